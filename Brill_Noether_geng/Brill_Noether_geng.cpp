@@ -20,6 +20,12 @@
 // 
 // TODO: test if the graph has a bridge.
 // 
+// Before starting a complete enumeration, its running time can be forecast with the option -F k/mod: this
+// runs k randomly chosen shards out of mod (one at a time, each in a child process), records how many
+// graphs every stage settles and how long it takes, and extrapolates the total running time (with
+// confidence intervals) per range of edge counts. It also recommends a number of shards for a few
+// target running times per shard (see shard_forecast.h).
+// 
 // For a summary of the command-line options, run the following command:
 //        ./Brill_Noether_geng -h
 // 
@@ -41,6 +47,12 @@ const int MAX_PARTS_PER_EDGE = 1;  // edges may be subdivided into at most 10 pa
 #include "graph6.h"   // from dgon-tools codebase
 #include "divisors.h" // from dgon-tools codebase
 #include "approximate_independent_sets.h" // from dgon-tools codebase
+#include "pipeline.h" // from dgon-tools codebase
+#include "results_db.h" // from dgon-tools codebase
+#include "alloc_stats.h" // from dgon-tools codebase
+#include "batched_kernels.h" // from dgon-tools codebase
+#include "shard_checkpoint.h" // from dgon-tools codebase
+#include "shard_forecast.h" // from dgon-tools codebase
 #include <cstdlib>
 #include <iostream>
 #include <cassert>
@@ -48,12 +60,19 @@ const int MAX_PARTS_PER_EDGE = 1;  // edges may be subdivided into at most 10 pa
 #include <cstdio>
 #include <cctype>
 #include <csignal>
+#include <thread>
+#include <deque>
+#include <ctime>
+#include <chrono>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
 
 const int MIN_N = 3;
 const int MAX_MOD = 1234567; // geng.c does not specify a maximum, but requires that (PRUNEMULT * mod) / PRUNEMULT == mod (without overflow), where PRUNEMULT = 50.
 
 #define USAGE \
-"Brill_Noether_geng [-Cmqvv] n [res/mod]"
+"Brill_Noether_geng [-Cbmpqvv] [-o file] [-k file] [-F k/mod] n [res/mod]"
 
 #define HELPTEXT \
 " Test the Brill–Noether conjecture for all graphs of a specified number of vertices.\n\
@@ -62,11 +81,21 @@ const int MAX_MOD = 1234567; // geng.c does not specify a maximum, but requires
    res/mod : only generate subset res out of subsets 0..mod-1\n\
 \n\
      -C    : only test biconnected graphs\n\
+     -b    : compute the gonalities in batches of 4 graphs (for n <= 16; see batched_kernels.h)\n\
      -m    : save memory at the expense of time\n\
+     -p    : pipelined (test graphs on a separate thread while geng generates the next ones,\n\
+             and write output on a third thread)\n\
      -v    : verbose\n\
      -vv   : extra verbose (outputs the conclusion for every graph)\n\
                            (WARNING: this produces a lot of output!)\n\
      -q    : suppress auxiliary output from geng (except from -v)\n\
+  -o file  : write the verdict for every graph to the binary results file \"file\"\n\
+             (see results_db.h; use query_results to read it; the file must not contain\n\
+             any results yet, unless the run is resumed with -k)\n\
+  -k file  : keep a checkpoint in \"file\" (written every minute and when interrupted);\n\
+             if the file exists, resume from it (see shard_checkpoint.h)\n\
+  -F k/mod : forecast the running time by running k random shards out of mod\n\
+             (see shard_forecast.h; cannot be combined with -b, -p, -o, -k or res/mod)\n\
 \n\
   See program text for much more information.\n"
 
@@ -92,32 +121,144 @@ long long tel = 0;
 long long probs = 0;
 bool badargs = false;
 bool arg_C = false;
+bool arg_b = false;
 bool arg_m = false;
+bool arg_p = false;
 bool arg_v = false;
 bool arg_q = false;
 bool arg_h = false;
 int verbosity = 0;
+results_db_writer results_db;
+
+// Checkpoints (-k). After a restart, the first resume_graphs graphs from geng are skipped (tel starts at
+// resume_graphs), and the last of them is compared with the fingerprint in the checkpoint.
+string checkpoint_path;
+shard_checkpoint checkpoint;
+long long resume_graphs = 0;
+long long generated = 0;                           // number of graphs generated by geng so far
+long long stage_counts[SHARD_CHECKPOINT_STAGES];   // number of graphs per stage (over all runs)
+string last_g6;                                    // graph6 string of graph number tel
+time_t last_checkpoint_time;
+
+// Forecasts (-F). Every sampled shard is run in a child process, which records its statistics in
+// forecast_sample, and sends them to the parent through a pipe.
+int forecast_k = 0;
+int forecast_mod = 0;
+shard_sample* forecast_sample = NULL;
+long long last_m;                                  // number of edges of the last graph that was checked
+int last_stage;                                    // stage in which it was settled
+
+// Append the verdict for the given graph to the results file (if requested).
+void record_result(long long ordinal, const my_graph& G, long long m, int stage, int gonality, long long Brill_Noether_bound) {
+	assert(stage >= 0 && stage < SHARD_CHECKPOINT_STAGES);
+	stage_counts[stage]++;
+	last_m = m;
+	last_stage = stage;
+	if (!results_db.is_open()) {
+		return;
+	}
+	results_db.append(ordinal, G.n, m, stage, gonality, Brill_Noether_bound, (gonality > Brill_Noether_bound ? RESULT_FAILS_BRILL_NOETHER : 0));
+}
+
+// Description of the enumeration for the header of the results file: the arguments that determine the
+// output of geng (cf. call_geng()).
+string enumeration_description(int n, int res, int mod) {
+	char tmp[100];
+	sprintf(tmp, "geng -%sd2 %d %d:%d %d/%d", (arg_C ? "C" : "c"), n, n, max(n, 3 * n - 9), res, mod);
+	return tmp;
+}
+
+// Report the outcome of the brute force search for the graph with the given ordinal.
+void report_gonality(long long ordinal, const my_graph& G, const string& g6_graph, long long m, int gon_g, long long Brill_Noether_bound) {
+	record_result(ordinal, G, m, STAGE_BRUTE_FORCE, gon_g, Brill_Noether_bound);
+	if (gon_g > Brill_Noether_bound) {
+		cout << "Graph " << ordinal << " (\"" << g6_graph << "\") fails Brill–Noether bound! Gonality: " << gon_g << ", bound: " << Brill_Noether_bound << "." << endl;
+		probs++;
+	}
+	else {
+		if (verbosity >= 2) { // running in very verbose mode
+			cout << "Graph " << ordinal << " (\"" << g6_graph << "\"): OK." << endl;
+		}
+	}
+}
+
+// Batched mode (-b): the graphs that need a brute force search are passed to a batch scheduler (see
+// batched_kernels.h), which reports them in the same order. The other data needed for the report are
+// kept in a queue in the meantime. So the verdicts for these graphs (in the output and in the results
+// file) come somewhat later than those for the graphs that are discarded by the quick tests.
+struct pending_graph {
+	long long ordinal;
+	string g6_graph;
+	long long m;
+	long long Brill_Noether_bound;
+};
+deque<pending_graph> pending_graphs;
+
+void report_batched_gonality(const my_graph& G, const int gonality, const int*) {
+	assert(!pending_graphs.empty());
+	const pending_graph& p = pending_graphs.front();
+	report_gonality(p.ordinal, G, p.g6_graph, p.m, gonality, p.Brill_Noether_bound);
+	pending_graphs.pop_front();
+}
+
+batch_scheduler batches(report_batched_gonality);
+
+// Write a checkpoint for the first tel graphs. This is skipped if some of these graphs are still waiting
+// for the batch scheduler.
+void write_checkpoint() {
+	if (checkpoint_path.empty() || !pending_graphs.empty()) {
+		return;
+	}
+	const time_t now = time(NULL);
+	checkpoint.seconds += now - last_checkpoint_time;
+	last_checkpoint_time = now;
+	checkpoint.graphs = tel;
+	checkpoint.problems = probs;
+	checkpoint.fingerprint = last_g6;
+	if (results_db.is_open()) {
+		results_db.flush(true);
+		checkpoint.records = results_db.records();
+	}
+	for (int i = 0; i < SHARD_CHECKPOINT_STAGES; i++) {
+		checkpoint.stages[i] = stage_counts[i];
+	}
+	checkpoint.write(checkpoint_path);
+}
+
+// Called after every graph (on the thread that checks the graphs).
+void checked_graph(const string& g6_graph) {
+	if (checkpoint_path.empty()) {
+		return;
+	}
+	last_g6 = g6_graph;
+	if (time(NULL) - last_checkpoint_time >= SHARD_CHECKPOINT_SECONDS) {
+		write_checkpoint();
+	}
+}
 
 void check_graph(const string& g6_graph) {
+	ALLOC_GRAPH(g6_graph);
 	tel++;
 	const my_graph G = parse_graph6(g6_graph);
 	assert(G.is_valid_undirected_graph());
 	const int n = G.n;
+	const long long m = G.count_edges();
+	const long long algebraic_genus = m - n + 1;
+	const long long Brill_Noether_bound = (algebraic_genus + 3) / 2;
 	for (int i = 0; i < n; i++) {
 		if (G.neighbours[i].size() <= 1) {
 			if (verbosity >= 2) { // running in very verbose mode
 				cout << "Graph " << tel << " (\"" << g6_graph << "\") has a vertex of degree 1. Skipping." << endl;
 			}
+			record_result(tel, G, m, STAGE_LEAF, 0, Brill_Noether_bound);
 			return;
 		}
 	}
-	const long long m = G.count_edges();
-	const long long algebraic_genus = m - n + 1;
-	const long long Brill_Noether_bound = (algebraic_genus + 3) / 2;
 	if (Brill_Noether_bound >= n - 2) {
 		if (verbosity >= 2) { // running in very verbose mode
 			cout << "Graph " << tel << " (\"" << g6_graph << "\") trivially meets the Brill–Noether bound (BN bound = " << Brill_Noether_bound << ", N - 2 = " << n - 2 << "). Skipping." << endl;
 		}
+		record_result(tel, G, m, STAGE_TRIVIAL_BOUND, 0, Brill_Noether_bound);
 		return;
 	}
 	// If we can find a sufficiently large independent set, the gonality will be small.
@@ -137,21 +278,57 @@ void check_graph(const string& g6_graph) {
 			if (verbosity >= 2) { // running in very verbose mode
 				cout << "Graph " << tel << " (\"" << g6_graph << "\") has a sufficiently large independent set. Skipping." << endl;
 			}
+			record_result(tel, G, m, STAGE_INDEPENDENT_SET, 0, Brill_Noether_bound);
 			return;
 		}
 	}
-	const int gon_g = find_gonality(G);
-	if (gon_g > Brill_Noether_bound) {
-		cout << "Graph " << tel << " (\"" << g6_graph << "\") fails Brill–Noether bound! Gonality: " << gon_g << ", bound: " << Brill_Noether_bound << "." << endl;
-		probs++;
+	if (arg_b) {
+		pending_graph p = {tel, g6_graph, m, Brill_Noether_bound};
+		pending_graphs.push_back(p);
+		batches.add(G);
+		return;
 	}
-	else {
-		if (verbosity >= 2) { // running in very verbose mode
-			cout << "Graph " << tel << " (\"" << g6_graph << "\"): OK." << endl;
+	report_gonality(tel, G, g6_graph, m, find_gonality(G), Brill_Noether_bound);
+}
+
+// Pipelined mode (-p): OUTPROC passes the graphs to a separate solver thread, which runs check_graph()
+// and passes its output to a writer thread (see pipeline.h). Geng keeps generating graphs in the meantime.
+// After a signal, the solver skips all remaining graphs in the ring, so the summary remains accurate.
+spsc_ring<string, PIPELINE_RING_SIZE> g6_ring;
+pipeline_writer* writer = NULL;
+thread solver_thread;
+
+void solver_loop() {
+	string g6_string;
+	while (g6_ring.pop(g6_string)) {
+		if (got_signal) {
+			continue;
 		}
+		writer->capture_begin();
+		check_graph(g6_string);
+		writer->capture_end();
+		checked_graph(g6_string);
+	}
+	if (arg_b) {
+		writer->capture_begin();
+		batches.finish();
+		writer->capture_end();
 	}
 }
 
+void start_pipeline() {
+	writer = new pipeline_writer();
+	solver_thread = thread(solver_loop);
+}
+
+void finish_pipeline() {
+	g6_ring.close();
+	solver_thread.join();
+	writer->finish();
+	delete writer;
+	writer = NULL;
+}
+
 extern "C" int GENG_MAIN(int argc, char *argv[]);
 
 extern "C" void OUTPROC(FILE *outfile, graph *g, int n) {
@@ -176,16 +353,158 @@ extern "C" void OUTPROC(FILE *outfile, graph *g, int n) {
 	string g6_string(g6_graph);
 	assert(!g6_string.empty() && g6_string[g6_string.size() - 1] == '\n');
 	g6_string.resize(g6_string.size() - 1);
-	check_graph(g6_string);
+	generated++;
+	if (generated <= resume_graphs) {
+		// Already checked before the restart.
+		if (generated == resume_graphs && g6_string != checkpoint.fingerprint) {
+			fprintf(stderr, ">E Error: graph %lld from geng does not match the checkpoint file \"%s\".\n", generated, checkpoint_path.c_str());
+			fprintf(stderr, "   Was the checkpoint written with different options?\n");
+			exit(1);
+		}
+	}
+	else if (arg_p) {
+		g6_ring.push(std::move(g6_string));
+	}
+	else if (forecast_sample != NULL) {
+		const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		check_graph(g6_string);
+		forecast_sample->add(last_m, last_stage, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+	}
+	else {
+		check_graph(g6_string);
+		checked_graph(g6_string);
+	}
 	//cout << "I see a graph: \"" << g6_string << "\"." << endl;
 	if (got_signal) {
 		fprintf(stderr, "\n\nReceived %s; aborting...\n", (got_signal == SIGINT ? "SIGINT" : (got_signal == SIGTERM ? "SIGTERM" : "unknown signal")));
+		if (arg_p) {
+			finish_pipeline();
+		}
+		else if (arg_b) {
+			batches.finish();
+		}
+		write_checkpoint();
+		results_db.close();
 		cout << endl;
 		cout << "Summary: tested " << tel << " graphs; found " << probs << " problems." << endl;
+		alloc_stats_report();
 		exit(1);
 	}
 }
 
+// Call geng for the graphs on n vertices; only generate shard res out of mod (if mod >= 1).
+void call_geng(int n, int res, int mod) {
+	assert(mod == -1 || (mod >= 1 && mod <= MAX_MOD && res >= 0 && res < mod));
+	
+	// Prepare args to pass to geng
+	char tmp[50];
+	const int ALL_ARGC = 5;
+	int all_argc = ALL_ARGC;
+	char* all_argv[ALL_ARGC + 1];
+	all_argv[all_argc] = NULL;
+	for (int i = 0; i < all_argc; i++) {
+		all_argv[i] = new char[100];
+		if (all_argv[i] == NULL) {
+			fprintf(stderr, ">E Error: failed to allocate memory in function call_geng.\n");
+			exit(1);
+		}
+	}
+	sprintf(all_argv[0], "geng");
+	sprintf(all_argv[1], "-%s%s%s%sd2", (arg_C ? "C" : "c"), (arg_m ? "m" : ""), (arg_v ? "v" : ""), (arg_q ? "q" : ""));
+	sprintf(all_argv[2], "%d", n);
+	sprintf(all_argv[3], "%d:%d", n, max(n, 3 * n - 9)); // 3 * n - 9 edges results in the Brill–Noether bound n - 2.5 (every simple non-complete graph has gonality at most n - 2)
+	if (mod != -1) { // equivalently: if "res/mod" was set
+		sprintf(tmp, "x%dX1000", 200 * mod);
+		strcat(all_argv[1], tmp);
+		sprintf(all_argv[4], "%d/%d", res, mod);
+	}
+	else {
+		all_argc--;
+		delete[] all_argv[4];
+		all_argv[4] = NULL;
+	}
+	
+	// Call geng
+	if (!arg_q) {
+		fprintf(stderr, ">A Calling");
+		for (int i = 0; i < all_argc; i++) {
+			fprintf(stderr, " %s", all_argv[i]);
+		}
+		fprintf(stderr, "\n");
+	}
+	GENG_MAIN(all_argc, all_argv);
+	for (int i = 0; i < all_argc; i++) {
+		delete[] all_argv[i];
+	}
+}
+
+// Forecast mode (-F): run every sampled shard in a child process (so that geng starts afresh every time),
+// which sends its statistics to the parent through a pipe. The shards run one at a time, so that their
+// running times are not distorted by each other.
+void run_forecast(int n) {
+	const vector<int> shards = choose_forecast_shards(n, forecast_k, forecast_mod);
+	vector<shard_sample> samples(shards.size());
+	for (size_t i = 0; i < shards.size(); i++) {
+		int fd[2];
+		if (pipe(fd) != 0) {
+			perror("pipe");
+			fprintf(stderr, ">E Error: failed to create a pipe for the forecast.\n");
+			exit(1);
+		}
+		cout.flush();
+		fflush(stdout);
+		fflush(stderr);
+		const pid_t pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			fprintf(stderr, ">E Error: failed to start shard %d/%d for the forecast.\n", shards[i], forecast_mod);
+			exit(1);
+		}
+		if (pid == 0) {
+			// Child: run the shard, and send the statistics.
+			close(fd[0]);
+			forecast_sample = new shard_sample;
+			forecast_sample->clear(shards[i]);
+			const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			call_geng(n, shards[i], forecast_mod);
+			forecast_sample->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			forecast_sample->problems = probs;
+			cout.flush();
+			const char* p = (const char*) forecast_sample;
+			for (size_t left = sizeof(shard_sample); left > 0; ) {
+				const ssize_t written = write(fd[1], p, left);
+				if (written <= 0) {
+					_exit(1);
+				}
+				p += written;
+				left -= written;
+			}
+			_exit(0);
+		}
+		close(fd[1]);
+		char* p = (char*) &samples[i];
+		size_t left = sizeof(shard_sample);
+		while (left > 0) {
+			const ssize_t got = read(fd[0], p, left);
+			if (got <= 0) {
+				break;
+			}
+			p += got;
+			left -= got;
+		}
+		close(fd[0]);
+		int status;
+		if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || left > 0) {
+			fprintf(stderr, ">E Error: shard %d/%d of the forecast failed.\n", shards[i], forecast_mod);
+			exit(1);
+		}
+		if (!arg_q) {
+			fprintf(stderr, ">A Forecast: shard %d/%d (%d of %d) took %.2f s.\n", shards[i], forecast_mod, (int) i + 1, forecast_k, samples[i].seconds);
+		}
+	}
+	print_shard_forecast(cout, n, forecast_mod, samples, MAX_MOD);
+}
+
 int main(const int argc, const char *argv[]) {
 	// Setup signal handler
 	struct sigaction sigIntHandler;
@@ -209,6 +528,7 @@ int main(const int argc, const char *argv[]) {
 	int res = -1;
 	int mod = -1;
 	int arg_mode = 0;
+	string results_path;
 	for (int i = 1; !badargs && i < argc; i++) {
 		if (arg_mode == 0 && argv[i][0] == '-') {
 			// argument is a switch
@@ -218,12 +538,60 @@ int main(const int argc, const char *argv[]) {
 					case 'C':
 						arg_C = true;
 						break;
+					case 'b':
+						arg_b = true;
+						break;
 					case 'h':
 						arg_h = true;
 						break;
 					case 'm':
 						arg_m = true;
 						break;
+					case 'p':
+						arg_p = true;
+						break;
+					case 'o':
+						// the file name is the next argument
+						if (j + 1 != l || i + 1 >= argc) {
+							badargs = true;
+						}
+						else {
+							results_path = argv[++i];
+						}
+						break;
+					case 'k':
+						// the file name is the next argument
+						if (j + 1 != l || i + 1 >= argc) {
+							badargs = true;
+						}
+						else {
+							checkpoint_path = argv[++i];
+						}
+						break;
+					case 'F':
+						// the sample size and number of shards are given in the next argument
+						if (j + 1 != l || i + 1 >= argc) {
+							badargs = true;
+						}
+						else {
+							i++;
+							if (sscanf(argv[i], "%d/%d", &forecast_k, &forecast_mod) != 2) {
+								badargs = true;
+							}
+							sprintf(tmp, "%d/%d", forecast_k, forecast_mod);
+							if (strcmp(tmp, argv[i])) {
+								badargs = true;
+							}
+							else if (forecast_mod < 1 || forecast_mod > MAX_MOD) {
+								fprintf(stderr, ">E Error: mod must be in the range [1,%d].\n", MAX_MOD);
+								badargs = true;
+							}
+							else if (forecast_k < 1 || forecast_k > forecast_mod) {
+								fprintf(stderr, ">E Error: the number of sampled shards must be in the range [1,mod].\n");
+								badargs = true;
+							}
+						}
+						break;
 					case 'q':
 						arg_q = true;
 						break;
@@ -284,6 +652,10 @@ int main(const int argc, const char *argv[]) {
 			badargs = true;
 		}
 	}
+	if (forecast_k > 0 && (arg_b || arg_p || !results_path.empty() || !checkpoint_path.empty() || arg_mode == 3)) {
+		fprintf(stderr, ">E Error: option -F cannot be combined with -b, -p, -o, -k or res/mod.\n");
+		badargs = true;
+	}
 	if (arg_h || badargs) {
 		fprintf(stderr, ">E Usage: %s\n", USAGE);
 		PUTHELPTEXT;
@@ -295,45 +667,69 @@ int main(const int argc, const char *argv[]) {
 		exit(1);
 	}
 	
-	// Prepare args to pass to geng
-	assert((arg_mode == 3) == (mod >= 0 && mod <= MAX_MOD && res >= 0 && res < mod));
-	const int ALL_ARGC = 5;
-	int all_argc = ALL_ARGC;
-	char* all_argv[ALL_ARGC + 1];
-	all_argv[all_argc] = NULL;
-	for (int i = 0; i < all_argc; i++) {
-		all_argv[i] = new char[max((size_t) 100, strlen(argv[0]) + 3)];
-		if (all_argv[i] == NULL) {
-			fprintf(stderr, ">E Error: failed to allocate memory in function main.\n");
-			exit(1);
-		}
+	// Resume from the checkpoint (if any), and open the results file
+	last_checkpoint_time = time(NULL);
+	const bool resume = (!checkpoint_path.empty() && checkpoint.read(checkpoint_path));
+	if (!results_path.empty()) {
+		results_db.open(results_path, n, (arg_mode == 3 ? res : 0), (arg_mode == 3 ? mod : 1), results_db_input_id(enumeration_description(n, res, mod)), resume);
 	}
-	sprintf(all_argv[0], "geng");
-	sprintf(all_argv[1], "-%s%s%s%sd2", (arg_C ? "C" : "c"), (arg_m ? "m" : ""), (arg_v ? "v" : ""), (arg_q ? "q" : ""));
-	sprintf(all_argv[2], "%d", n);
-	sprintf(all_argv[3], "%d:%d", n, max(n, 3 * n - 9)); // 3 * n - 9 edges results in the Brill–Noether bound n - 2.5 (every simple non-complete graph has gonality at most n - 2)
-	if (arg_mode == 3) { // equivalently: if "res/mod" was set
-		sprintf(tmp, "x%dX1000", 200 * mod);
-		strcat(all_argv[1], tmp);
-		sprintf(all_argv[4], "%d/%d", res, mod);
+	if (!checkpoint_path.empty()) {
+		if (resume) {
+			if (checkpoint.n != n || checkpoint.res != (arg_mode == 3 ? res : 0) || checkpoint.mod != (arg_mode == 3 ? mod : 1)) {
+				fprintf(stderr, ">E Error: checkpoint file \"%s\" belongs to a different enumeration.\n", checkpoint_path.c_str());
+				exit(1);
+			}
+			resume_graphs = tel = checkpoint.graphs;
+			probs = checkpoint.problems;
+			last_g6 = checkpoint.fingerprint;
+			for (int i = 0; i < SHARD_CHECKPOINT_STAGES; i++) {
+				stage_counts[i] = checkpoint.stages[i];
+			}
+			if (results_db.is_open() && checkpoint.records >= 0) {
+				results_db.truncate(checkpoint.records);
+			}
+			if (!arg_q) {
+				fprintf(stderr, ">A Resuming from checkpoint: skipping the checks for the first %lld graphs.\n", resume_graphs);
+			}
+		}
+		else {
+			checkpoint.n = n;
+			checkpoint.res = (arg_mode == 3 ? res : 0);
+			checkpoint.mod = (arg_mode == 3 ? mod : 1);
+		}
 	}
-	else {
-		all_argc--;
-		all_argv[4] = NULL;
+	
+	// Forecast (instead of the enumeration)
+	if (forecast_k > 0) {
+		run_forecast(n);
+		return 0;
 	}
 	
 	// Call geng
-	if (!arg_q) {
-		fprintf(stderr, ">A Calling");
-		for (int i = 0; i < all_argc; i++) {
-			fprintf(stderr, " %s", all_argv[i]);
-		}
-		fprintf(stderr, "\n");
+	if (arg_b) {
+		alloc_stats_disable_graphs(); // most graphs are solved later, in batches
 	}
-	GENG_MAIN(all_argc, all_argv);
+	assert((arg_mode == 3) == (mod >= 0 && mod <= MAX_MOD && res >= 0 && res < mod));
+	if (arg_p) {
+		start_pipeline();
+	}
+	call_geng(n, res, mod);
+	if (arg_p) {
+		finish_pipeline();
+	}
+	else if (arg_b) {
+		batches.finish();
+	}
+	if (generated < resume_graphs) {
+		fprintf(stderr, ">E Error: geng generated only %lld graphs, but the checkpoint file \"%s\" records %lld.\n", generated, checkpoint_path.c_str(), resume_graphs);
+		exit(1);
+	}
+	write_checkpoint();
+	results_db.close();
 	
 	// Print summary
 	cout << endl;
 	cout << "Summary: tested " << tel << " graphs; found " << probs << " problems." << endl;
+	alloc_stats_report();
 	return 0;
 }
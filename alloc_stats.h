@@ -0,0 +1,380 @@
+// Opt-in instrumentation of heap allocations.
+//
+// If the programs are compiled with -DTRACK_ALLOCATIONS, this file replaces the global operator new and
+// operator delete, and counts the number of heap allocations and the number of bytes allocated. The counts
+// are kept per phase: a phase is a named region of code, marked with
+//
+//     ALLOC_PHASE("name");
+//
+// at the start of a block (the phase ends at the end of the block, and phases can be nested; allocations
+// are attributed to the innermost phase). Allocations outside any phase are counted as "other". Likewise,
+//
+//     ALLOC_GRAPH(G.graph_name);
+//
+// at the start of a block marks the processing of a single graph, so that the final report can show the
+// number of allocations per graph (and the graph with the most allocations).
+//
+// Besides the counts, the report shows high-water marks: the largest amount of heap memory that was in use
+// at any time during a phase or graph, on top of the memory that was in use when the phase or graph began
+// (i.e. the counters are reset at every phase and graph boundary, and the maximum over all occurrences is
+// reported). The high-water mark of the whole run, and the peak resident set size of the process (as
+// reported by getrusage()) are shown as well. No external tools are needed.
+//
+// The counts and high-water marks for phases and graphs are kept per thread, so they only cover the work
+// done by the thread that entered the phase or graph (e.g. in pipelined mode, the allocations of the reader
+// thread are not counted towards the graphs). Memory stays charged to the thread that allocated it until it
+// is freed, also if another thread frees it (e.g. in pipelined mode, the reader thread allocates the graphs
+// and the solver thread frees them): every allocation has a small header that records the allocating
+// thread. If the graphs are not processed one at a time within ALLOC_GRAPH (e.g. if they are queued and
+// solved later, or on other threads), the program should call alloc_stats_disable_graphs(), as the
+// per-graph statistics would be meaningless.
+//
+// Without -DTRACK_ALLOCATIONS, the macros expand to nothing and the functions do nothing, so the
+// instrumentation costs nothing in normal builds. To build all programs with the instrumentation, run
+//
+//     make -B BUILD_FLAGS=-DTRACK_ALLOCATIONS
+//
+// Note: the replacement operator new is defined in this header, which is fine because every program
+// consists of a single translation unit. Memory sizes are measured with malloc_usable_size() (glibc), and
+// include the header.
+//
+// This file defines the following:
+//
+//      * ALLOC_PHASE(name), ALLOC_GRAPH(name)
+//        Scoped markers for phases and graphs (see above).
+//
+//      * void alloc_stats_disable_graphs()
+//        Disable the per-graph statistics (see above).
+//
+//      * void alloc_stats_report()
+//        Print the allocation statistics on standard error (prints nothing without -DTRACK_ALLOCATIONS).
+//
+
+#ifndef __ALLOC_STATS_H__
+#define __ALLOC_STATS_H__
+
+#include <iostream>
+#include <string>
+
+
+#ifdef TRACK_ALLOCATIONS
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <iomanip>
+#include <malloc.h>
+#include <sys/resource.h>
+
+
+const int ALLOC_MAX_PHASES = 32; // maximum number of distinct phase names
+
+
+struct __alloc_counter {
+	std::atomic<long long> allocations;
+	std::atomic<long long> bytes;
+	std::atomic<long long> high_water; // largest high-water mark of any occurrence of the phase
+};
+
+// Phase 0 is "other". All of these are zero-initialised before any constructor runs, so operator new
+// can be used during static initialisation.
+const char* __alloc_phase_names[ALLOC_MAX_PHASES];
+__alloc_counter __alloc_counters[ALLOC_MAX_PHASES];
+std::atomic<int> __alloc_num_phases(1);
+std::mutex __alloc_register_mutex;
+thread_local int __alloc_current_phase = 0;
+thread_local bool __alloc_paused = false; // set while the instrumentation itself allocates memory
+
+// Memory in use (allocated minus freed) for the whole process, and its largest value.
+std::atomic<long long> __alloc_in_use(0);
+std::atomic<long long> __alloc_high_water(0);
+
+// Per-thread statistics: the memory allocated by the thread that is still in use (it may be freed by other
+// threads, hence atomic), the largest value of in_use since the start of the innermost phase or graph, and
+// the number of allocations and bytes allocated. These are allocated with calloc() on first use and never
+// freed, as the memory allocated by a thread may be freed after the thread has exited.
+struct __alloc_thread_stats {
+	std::atomic<long long> in_use;
+	long long high_water, allocations, bytes;
+};
+thread_local __alloc_thread_stats* __alloc_thread = NULL;
+
+__alloc_thread_stats& __alloc_this_thread() {
+	if (__alloc_thread == NULL) {
+		void* p = calloc(1, sizeof(__alloc_thread_stats));
+		if (p == NULL) {
+			throw std::bad_alloc();
+		}
+		__alloc_thread = new (p) __alloc_thread_stats();
+	}
+	return *__alloc_thread;
+}
+
+// Size of the header in front of every allocation, which stores a pointer to the __alloc_thread_stats of
+// the allocating thread (a multiple of the alignment of malloc(), so that the alignment is preserved).
+const std::size_t __ALLOC_HEADER = alignof(std::max_align_t);
+static_assert(__ALLOC_HEADER >= sizeof(__alloc_thread_stats*), "allocation header too small");
+
+// Per-graph statistics.
+bool __alloc_graphs_disabled = false;
+long long __alloc_graphs = 0;
+long long __alloc_graph_allocations = 0;
+long long __alloc_graph_bytes = 0;
+long long __alloc_graph_max_allocations = -1;
+long long __alloc_graph_max_high_water = -1;
+std::string* __alloc_graph_max_allocations_name = NULL;
+std::string* __alloc_graph_max_high_water_name = NULL;
+
+
+// Returns the index of the phase with the given name (registering it if necessary).
+int __alloc_register_phase(const char* name) {
+	std::lock_guard<std::mutex> lock(__alloc_register_mutex);
+	const int k = __alloc_num_phases.load();
+	for (int i = 1; i < k; i++) {
+		if (strcmp(__alloc_phase_names[i], name) == 0) {
+			return i;
+		}
+	}
+	assert(k < ALLOC_MAX_PHASES);
+	__alloc_phase_names[k] = name;
+	__alloc_num_phases.store(k + 1);
+	return k;
+}
+
+void __alloc_totals(long long& allocations, long long& bytes) {
+	allocations = bytes = 0;
+	for (int i = 0; i < ALLOC_MAX_PHASES; i++) {
+		allocations += __alloc_counters[i].allocations.load(std::memory_order_relaxed);
+		bytes += __alloc_counters[i].bytes.load(std::memory_order_relaxed);
+	}
+}
+
+void __alloc_update_max(std::atomic<long long>& x, long long value) {
+	long long old = x.load(std::memory_order_relaxed);
+	while (value > old && !x.compare_exchange_weak(old, value, std::memory_order_relaxed)) {}
+}
+
+// Measure the high-water mark of the current thread from the constructor to the call to end().
+struct __alloc_high_water_scope {
+	long long base, outer_high_water;
+	__alloc_high_water_scope() : base(__alloc_this_thread().in_use.load(std::memory_order_relaxed)), outer_high_water(__alloc_this_thread().high_water) {
+		__alloc_this_thread().high_water = base;
+	}
+	// Returns the high-water mark since the constructor, and passes it on to the enclosing scope.
+	long long end() {
+		__alloc_thread_stats& t = __alloc_this_thread();
+		const long long ret = t.high_water - base;
+		if (outer_high_water > t.high_water) {
+			t.high_water = outer_high_water;
+		}
+		return ret;
+	}
+};
+
+struct __alloc_phase_scope {
+	int phase, previous;
+	__alloc_high_water_scope high_water;
+	__alloc_phase_scope(int _phase) : phase(_phase), previous(__alloc_current_phase) {
+		__alloc_current_phase = phase;
+	}
+	~__alloc_phase_scope() {
+		__alloc_update_max(__alloc_counters[phase].high_water, high_water.end());
+		__alloc_current_phase = previous;
+	}
+};
+
+struct __alloc_graph_scope {
+	const std::string& name;
+	long long allocations, bytes;
+	__alloc_high_water_scope high_water;
+	__alloc_graph_scope(const std::string& _name) : name(_name), allocations(__alloc_this_thread().allocations), bytes(__alloc_this_thread().bytes) {}
+	~__alloc_graph_scope() {
+		const long long h = high_water.end();
+		if (__alloc_graphs_disabled) {
+			return;
+		}
+		const long long a = __alloc_this_thread().allocations - allocations;
+		const long long b = __alloc_this_thread().bytes - bytes;
+		__alloc_graphs++;
+		__alloc_graph_allocations += a;
+		__alloc_graph_bytes += b;
+		__alloc_paused = true;
+		if (a > __alloc_graph_max_allocations) {
+			__alloc_graph_max_allocations = a;
+			if (__alloc_graph_max_allocations_name == NULL) {
+				__alloc_graph_max_allocations_name = new std::string();
+			}
+			*__alloc_graph_max_allocations_name = name;
+		}
+		if (h > __alloc_graph_max_high_water) {
+			__alloc_graph_max_high_water = h;
+			if (__alloc_graph_max_high_water_name == NULL) {
+				__alloc_graph_max_high_water_name = new std::string();
+			}
+			*__alloc_graph_max_high_water_name = name;
+		}
+		__alloc_paused = false;
+	}
+};
+
+#define __ALLOC_CONCAT2(a, b) a##b
+#define __ALLOC_CONCAT(a, b) __ALLOC_CONCAT2(a, b)
+#define ALLOC_PHASE(name) \
+	static const int __ALLOC_CONCAT(__alloc_phase_id_, __LINE__) = __alloc_register_phase(name); \
+	__alloc_phase_scope __ALLOC_CONCAT(__alloc_phase_scope_, __LINE__)(__ALLOC_CONCAT(__alloc_phase_id_, __LINE__))
+#define ALLOC_GRAPH(name) \
+	__alloc_graph_scope __ALLOC_CONCAT(__alloc_graph_scope_, __LINE__)(name)
+
+void alloc_stats_disable_graphs() {
+	__alloc_graphs_disabled = true;
+}
+
+
+// Replacement allocation functions.
+void* __alloc_tracked(std::size_t size) {
+	if (size > SIZE_MAX - __ALLOC_HEADER) {
+		throw std::bad_alloc();
+	}
+	char* p = (char*) malloc(__ALLOC_HEADER + size);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	__alloc_thread_stats& t = __alloc_this_thread();
+	*(__alloc_thread_stats**) p = &t;
+	if (!__alloc_paused) {
+		__alloc_counter& c = __alloc_counters[__alloc_current_phase];
+		c.allocations.fetch_add(1, std::memory_order_relaxed);
+		c.bytes.fetch_add(size, std::memory_order_relaxed);
+		t.allocations++;
+		t.bytes += size;
+	}
+	const long long usable = malloc_usable_size(p);
+	__alloc_update_max(__alloc_high_water, __alloc_in_use.fetch_add(usable, std::memory_order_relaxed) + usable);
+	const long long in_use = t.in_use.fetch_add(usable, std::memory_order_relaxed) + usable;
+	if (in_use > t.high_water) {
+		t.high_water = in_use;
+	}
+	return p + __ALLOC_HEADER;
+}
+
+// Free memory allocated by __alloc_tracked(), and charge this to the thread that allocated it.
+void __alloc_free(void* ptr) {
+	if (ptr != NULL) {
+		char* p = (char*) ptr - __ALLOC_HEADER;
+		const long long usable = malloc_usable_size(p);
+		__alloc_in_use.fetch_sub(usable, std::memory_order_relaxed);
+		(*(__alloc_thread_stats**) p)->in_use.fetch_sub(usable, std::memory_order_relaxed);
+		free(p);
+	}
+}
+
+void* operator new(std::size_t size) {
+	return __alloc_tracked(size);
+}
+
+void* operator new[](std::size_t size) {
+	return __alloc_tracked(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return __alloc_tracked(size);
+	}
+	catch (...) {
+		return NULL;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return __alloc_tracked(size);
+	}
+	catch (...) {
+		return NULL;
+	}
+}
+
+void operator delete(void* p) noexcept {
+	__alloc_free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	__alloc_free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+	__alloc_free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+	__alloc_free(p);
+}
+
+
+// Print the allocation statistics on standard error.
+void alloc_stats_report() {
+	std::ostream& os = std::cerr;
+	__alloc_paused = true;
+	const int k = __alloc_num_phases.load();
+	__alloc_phase_names[0] = "other";
+	long long allocations, bytes;
+	__alloc_totals(allocations, bytes);
+	const long long graphs = (__alloc_graphs == 0 ? 1 : __alloc_graphs);
+	os << "Allocation statistics:" << std::endl;
+	os << "    " << std::left << std::setw(30) << "phase" << std::right << std::setw(15) << "allocations" << std::setw(18) << "bytes" << std::setw(18) << "allocations/graph" << std::setw(18) << "high-water bytes" << std::endl;
+	for (int i = 0; i <= k; i++) {
+		const char* name = (i < k ? __alloc_phase_names[i] : "total");
+		const long long a = (i < k ? __alloc_counters[i].allocations.load() : allocations);
+		const long long b = (i < k ? __alloc_counters[i].bytes.load() : bytes);
+		os << "    " << std::left << std::setw(30) << name << std::right << std::setw(15) << a << std::setw(18) << b;
+		if (__alloc_graphs_disabled) {
+			os << std::setw(18) << "-";
+		}
+		else {
+			os << std::setw(18) << std::fixed << std::setprecision(1) << (double) a / graphs;
+		}
+		if (i == 0) {
+			os << std::setw(18) << "-"; // "other" is not a scope
+		}
+		else {
+			os << std::setw(18) << (i < k ? __alloc_counters[i].high_water.load() : __alloc_high_water.load());
+		}
+		os << std::endl;
+	}
+	if (__alloc_graphs_disabled) {
+		os << "    Graphs: no per-graph statistics (the graphs are not processed one at a time in this mode)." << std::endl;
+	}
+	else {
+		os << "    Graphs: " << __alloc_graphs << "; allocations per graph: " << std::fixed << std::setprecision(1) << (double) __alloc_graph_allocations / graphs << " (" << (double) __alloc_graph_bytes / graphs << " bytes)";
+		if (__alloc_graph_max_allocations_name != NULL) {
+			os << "; at most " << __alloc_graph_max_allocations << " (graph \"" << *__alloc_graph_max_allocations_name << "\")";
+			os << "; largest high-water mark " << __alloc_graph_max_high_water << " bytes (graph \"" << *__alloc_graph_max_high_water_name << "\")";
+		}
+		os << "." << std::endl;
+	}
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		os << "    Peak resident set size: " << usage.ru_maxrss << " kB." << std::endl;
+	}
+	__alloc_paused = false;
+}
+
+
+#else // TRACK_ALLOCATIONS
+
+
+#define ALLOC_PHASE(name)
+#define ALLOC_GRAPH(name)
+
+inline void alloc_stats_disable_graphs() {}
+inline void alloc_stats_report() {}
+
+
+#endif // TRACK_ALLOCATIONS
+
+#endif
@@ -35,6 +35,7 @@
 #define EXTRA_CHECKS
 
 #include "graphs.h"
+#include "alloc_stats.h"
 #include <cstdlib>
 #include <utility>
 #include <bitset>
@@ -98,6 +99,7 @@ bool __check_cliq(const my_graph& G, const vertex_set& S) {
 // the role of this algorithm in Ramsey theory.
 // 
 std::pair<vertex_set, vertex_set> Boppana_Halldorsson_Ramsey(const my_graph& G, const vertex_set& S) {
+	ALLOC_PHASE("Boppana_Halldorsson_Ramsey");
 	// Check if S is empty.
 	if (S.none()) {
 		return std::make_pair(vertex_set(0ul), vertex_set(0ul));
@@ -167,7 +169,9 @@ std::pair<vertex_set, vertex_set> Boppana_Halldorsson_Ramsey(const my_graph& G,
 // For an analysis of the approximation rate of this algorithm, see the paper [1].
 // 
 vertex_set approximate_maximum_independent_set(const my_graph& G) {
-	assert(G.is_valid_undirected_graph()); // check validy AND populate __adj_matr[][]
+	bool valid = G.is_valid_undirected_graph(); // check validy AND populate __adj_matr[][] (not inside assert(), which disappears with -DNDEBUG)
+	assert(valid);
+	(void) valid;
 	assert(G.n <= MAX_N);
 	vertex_set S, best_indep;
 	for (int i = 0; i < G.n; i++) {
@@ -0,0 +1,218 @@
+// Per-graph choice of the gonality engine, based on short probing runs.
+//
+// There are several ways to compute the gonality (see divisors.h and parallel_rank.h), and which one is the
+// fastest depends on the graph in ways that are hard to predict. Before the real computation, the autotuner
+// therefore times every applicable engine on the same small problem: deciding whether the gonality is at
+// most p, where p is the largest degree for which the brute force search visits at most AUTOTUNE_PROBE_LEAVES
+// divisors (a few thousand, so the probe is cheap but still takes long enough to be timed reliably). Every
+// probe is repeated AUTOTUNE_PROBE_REPEATS times, and the fastest run counts. Then it commits to the fastest
+// engine. If the probe already finds the gonality (i.e. if the gonality is at most p), this result is used
+// directly.
+//
+// The decision is cached by a coarse signature of the graph: the number of vertices, the number of edges,
+// the maximum edge multiplicity, and the fraction of vertices of degree 2 (in steps of 10%). Later graphs
+// with the same signature use the cached engine without probing.
+//
+// The engines are:
+//      * one-pass: find_gonality() (branch and bound over superstable configurations);
+//      * degree loop: find_gonality_by_degree();
+//      * degree loop (parallel rank): as the previous one, with the parallel positive rank test for every
+//        graph size (only if parallel_rank.h is included and installed, i.e. on machines with several cores).
+//
+// This file defines the following:
+//
+//      * struct autotune_report
+//        The engine used for a graph, whether it was taken from the cache, and the probe timings.
+//
+//      * int autotuned_gonality(const my_graph& G, autotune_report& report)
+//        Compute the gonality of G with the engine chosen by the autotuner (see above). The optimal divisor
+//        is stored in __partial_divisor, as for find_gonality().
+//
+//      * void print_autotune_report(std::ostream& os, const autotune_report& report, bool show_timings)
+//        Print a line with the engine used for a graph (and optionally the probe timings).
+//
+
+#ifndef __AUTOTUNE_H__
+#define __AUTOTUNE_H__
+
+#include "graphs.h"
+#include "divisors.h"
+#include "search_ranges.h"
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+
+const unsigned long long AUTOTUNE_PROBE_LEAVES = 4096; // maximum number of leaves of the probe (in the degree loop)
+const int AUTOTUNE_PROBE_REPEATS = 3;                  // number of runs of every probe (the fastest one counts)
+const int AUTOTUNE_ENGINES = 3;
+
+
+int __engine_one_pass(const my_graph& G, const int max_degree) {
+	return find_gonality(G, max_degree);
+}
+
+int __engine_degree_loop(const my_graph& G, const int max_degree) {
+	return find_gonality_by_degree(G, max_degree);
+}
+
+int __engine_degree_loop_parallel(const my_graph& G, const int max_degree) {
+	const int min_n = __parallel_rank_min_n;
+	__parallel_rank_min_n = 1;
+	const int ret = __engine_degree_loop(G, max_degree);
+	__parallel_rank_min_n = min_n;
+	return ret;
+}
+
+struct __autotune_engine {
+	const char* name;
+	int (*fn)(const my_graph&, const int);
+	bool needs_parallel_rank;
+};
+
+const __autotune_engine __autotune_engines[AUTOTUNE_ENGINES] = {
+	{"one-pass", __engine_one_pass, false},
+	{"degree loop", __engine_degree_loop, false},
+	{"degree loop (parallel rank)", __engine_degree_loop_parallel, true},
+};
+
+
+struct autotune_report {
+	int engine;                          // index of the engine used
+	bool cached;                         // true if the engine was taken from the cache
+	bool solved_by_probe;                // true if the probe already found the gonality
+	int probe_degree;                    // maximum degree in the probe (0 if there was no probe)
+	double probe_ms[AUTOTUNE_ENGINES];   // fastest probe time for every engine (-1 if not applicable or not run)
+};
+
+
+// Coarse graph signature (see above).
+struct __autotune_signature {
+	int n, m, max_multiplicity, degree_2_tenths;
+	bool operator<(const __autotune_signature& o) const {
+		if (n != o.n) return n < o.n;
+		if (m != o.m) return m < o.m;
+		if (max_multiplicity != o.max_multiplicity) return max_multiplicity < o.max_multiplicity;
+		return degree_2_tenths < o.degree_2_tenths;
+	}
+};
+
+std::map<__autotune_signature, int> __autotune_cache;
+
+__autotune_signature __autotune_signature_of(const my_graph& G) {
+	__autotune_signature sig;
+	sig.n = G.n;
+	sig.m = G.count_edges();
+	sig.max_multiplicity = 0;
+	int degree_2 = 0;
+	std::vector<int> count(G.n, 0);
+	for (int v = 0; v < G.n; v++) {
+		degree_2 += (G.neighbours[v].size() == 2);
+		for (int w : G.neighbours[v]) {
+			count[w]++;
+			if (count[w] > sig.max_multiplicity) {
+				sig.max_multiplicity = count[w];
+			}
+		}
+		for (int w : G.neighbours[v]) {
+			count[w] = 0;
+		}
+	}
+	sig.degree_2_tenths = (10 * degree_2) / (G.n > 0 ? G.n : 1);
+	return sig;
+}
+
+bool __autotune_applicable(const int engine) {
+	return !__autotune_engines[engine].needs_parallel_rank || __parallel_has_positive_rank != NULL;
+}
+
+
+// Compute the gonality of G with the engine chosen by the autotuner (see above).
+//
+// Changes the same global variables as find_gonality() and find_gonality_by_degree().
+int autotuned_gonality(const my_graph& G, autotune_report& report) {
+	report.cached = false;
+	report.solved_by_probe = false;
+	report.probe_degree = 0;
+	for (int e = 0; e < AUTOTUNE_ENGINES; e++) {
+		report.probe_ms[e] = -1;
+	}
+	const __autotune_signature sig = __autotune_signature_of(G);
+	std::map<__autotune_signature, int>::const_iterator it = __autotune_cache.find(sig);
+	if (it != __autotune_cache.end()) {
+		report.engine = it->second;
+		report.cached = true;
+		return __autotune_engines[report.engine].fn(G, MAX_N);
+	}
+
+	// Probe degree: the largest p < n such that the degree loop visits at most AUTOTUNE_PROBE_LEAVES leaves at degree p.
+	int p = 1;
+	while (p + 1 < G.n && count_search_leaves(G.n, p + 1) <= AUTOTUNE_PROBE_LEAVES) {
+		p++;
+	}
+	report.probe_degree = p;
+	int best = -1;
+	for (int e = 0; e < AUTOTUNE_ENGINES; e++) {
+		if (!__autotune_applicable(e)) {
+			continue;
+		}
+		for (int r = 0; r < AUTOTUNE_PROBE_REPEATS; r++) {
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			const int gon = __autotune_engines[e].fn(G, p);
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (gon != -1) {
+				// The probe found the gonality; no need to try the other engines.
+				report.probe_ms[e] = ms;
+				report.engine = e;
+				report.solved_by_probe = true;
+				return gon;
+			}
+			if (r == 0 || ms < report.probe_ms[e]) {
+				report.probe_ms[e] = ms;
+			}
+		}
+		if (best == -1 || report.probe_ms[e] < report.probe_ms[best]) {
+			best = e;
+		}
+	}
+	assert(best != -1);
+	__autotune_cache[sig] = best;
+	report.engine = best;
+	return __autotune_engines[best].fn(G, MAX_N);
+}
+
+
+// Print a line with the engine used for a graph (and optionally the probe timings).
+void print_autotune_report(std::ostream& os, const autotune_report& report, bool show_timings) {
+	os << "  Engine: " << __autotune_engines[report.engine].name;
+	if (report.cached) {
+		os << " (cached)";
+	}
+	else if (report.solved_by_probe) {
+		os << " (solved by the probe up to degree " << report.probe_degree << ")";
+	}
+	else {
+		os << " (fastest on the probe up to degree " << report.probe_degree << ")";
+	}
+	if (show_timings && !report.cached) {
+		const std::ios::fmtflags flags = os.flags();
+		const std::streamsize precision = os.precision();
+		os << "; probe times:" << std::fixed << std::setprecision(3);
+		bool first = true;
+		for (int e = 0; e < AUTOTUNE_ENGINES; e++) {
+			if (report.probe_ms[e] >= 0) {
+				os << (first ? " " : ", ") << __autotune_engines[e].name << ' ' << report.probe_ms[e] << " ms";
+				first = false;
+			}
+		}
+		os.flags(flags);
+		os.precision(precision);
+	}
+	os << std::endl;
+}
+
+
+#endif
@@ -0,0 +1,378 @@
+// Lockstep gonality computation for batches of small simple graphs.
+//
+// For graphs on a dozen vertices, a single gonality computation takes only a few microseconds, and most of
+// that time goes into per-call overhead and hard-to-predict branches in Dhar's burning algorithm. This file
+// computes the gonality of up to BATCH_LANES simple graphs on the same number of vertices n <= BATCH_MAX_N
+// at once, with every graph in a 16-bit lane of a 64-bit word:
+//     * a vertex set is a bitmask per lane, so the adjacency "matrix" of all graphs in the batch takes n words;
+//     * a divisor is stored as n words, with the number of chips of vertex v in graph l in lane l of word v;
+//     * Dhar's burning algorithm burns a vertex v in all graphs at once, by counting the burnt neighbours of v
+//       in every lane (a lane-wise popcount) and comparing the counts with the chips on v (a lane-wise
+//       comparison). Chip-firing is done in the same way.
+// There are no data-dependent branches per graph, only per batch.
+//
+// The search is the one-pass search from find_gonality() (divisors.h), run in lockstep: all graphs in the
+// batch have the same vertex set, so the superstable configurations are enumerated once for the whole batch,
+// and every configuration is tested on the graphs for which it is superstable and can still improve the best
+// divisor found so far. The minimal number of chips on v0 is computed lane by lane. Every graph gets the same
+// gonality and the same divisor as with find_gonality().
+//
+// Multigraphs and graphs on more than BATCH_MAX_N vertices cannot be batched; batch_scheduler passes them to
+// find_gonality().
+//
+// This file defines the following:
+//
+//      * bool is_batchable(const my_graph& G)
+//        Test whether G can be put in a batch (simple graph on at most BATCH_MAX_N vertices).
+//
+//      * struct graph_batch
+//        A batch of graphs on the same number of vertices, and their gonalities and optimal divisors.
+//
+//      * void solve_batch(graph_batch& B)
+//        Compute the gonality of every graph in the batch.
+//
+//      * class batch_scheduler
+//        Collects a window of graphs, solves them in batches (grouped by number of vertices), and reports the
+//        results in input order.
+//
+
+#ifndef __BATCHED_KERNELS_H__
+#define __BATCHED_KERNELS_H__
+
+#include "graphs.h"
+#include "divisors.h"
+#include "alloc_stats.h"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+
+const int BATCH_LANES = 4;    // number of graphs per batch (16-bit lanes in a 64-bit word)
+const int BATCH_MAX_N = 16;   // maximum number of vertices (bits per lane)
+const int BATCH_WINDOW = 64;  // number of graphs collected by batch_scheduler before solving them
+
+const uint64_t __LANE_ONES = 0x0001000100010001ULL;  // 1 in every lane
+const uint64_t __LANE_HIGH = 0x8000800080008000ULL;  // top bit of every lane
+const uint64_t __LANE_LOW = 0x7FFF7FFF7FFF7FFFULL;   // all but the top bit of every lane
+
+
+
+// Lane-wise operations on 64-bit words. A "lane mask" has all 16 bits of a lane set or cleared.
+
+// Number of set bits in every lane.
+inline uint64_t __lane_popcount(uint64_t x) {
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (x + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+}
+
+// Top bit of every lane in which x > y (both must be less than 0x8000 in every lane).
+inline uint64_t __lane_greater(const uint64_t x, const uint64_t y) {
+	return ((x | __LANE_HIGH) - (y + __LANE_ONES)) & __LANE_HIGH;
+}
+
+// Top bit of every lane in which x is nonzero.
+inline uint64_t __lane_nonzero(const uint64_t x) {
+	return (((x & __LANE_LOW) + __LANE_LOW) | x) & __LANE_HIGH;
+}
+
+// Lane mask of the lanes whose top bit is set.
+inline uint64_t __lane_expand(const uint64_t top) {
+	return (top >> 15) * 0xFFFF;
+}
+
+// Lane mask of lane l.
+inline uint64_t __lane_mask(const int l) {
+	return 0xFFFFULL << (16 * l);
+}
+
+
+
+// Test whether G can be put in a batch (simple graph on at most BATCH_MAX_N vertices).
+bool is_batchable(const my_graph& G) {
+	if (G.n < 1 || G.n > BATCH_MAX_N) {
+		return false;
+	}
+	for (int v = 0; v < G.n; v++) {
+		unsigned mask = 0;
+		for (int w : G.neighbours[v]) {
+			if (mask & (1u << w)) {
+				return false;
+			}
+			mask |= (1u << w);
+		}
+	}
+	return true;
+}
+
+
+
+// A batch of at most BATCH_LANES simple graphs on n vertices.
+//
+// Usage:
+//     graph_batch B;
+//     B.init(n);
+//     B.add(G1);      // returns the lane of G1 (0)
+//     B.add(G2);      // returns the lane of G2 (1)
+//     solve_batch(B); // now B.gonality[l] and B.divisor[l] are set for every lane
+struct graph_batch {
+	int n, size;
+	uint64_t adj[BATCH_MAX_N];               // lane l of adj[v] is the neighbourhood of v in graph l
+	uint64_t vertices;                       // lane l contains the bits 0, ..., n - 1
+	int gonality[BATCH_LANES];
+	int divisor[BATCH_LANES][BATCH_MAX_N];   // v0-reduced positive rank divisor of minimal degree
+
+	void init(const int _n) {
+		assert(_n >= 1 && _n <= BATCH_MAX_N);
+		n = _n;
+		size = 0;
+		vertices = ((1ULL << n) - 1) * __LANE_ONES;
+		for (int v = 0; v < BATCH_MAX_N; v++) {
+			adj[v] = 0;
+		}
+	}
+
+	int add(const my_graph& G) {
+		assert(size < BATCH_LANES && G.n == n && is_batchable(G));
+		for (int v = 0; v < n; v++) {
+			for (int w : G.neighbours[v]) {
+				adj[v] |= (1ULL << w) << (16 * size);
+			}
+		}
+		return size++;
+	}
+};
+
+
+
+// Global variables for the batched search (cf. the one-pass search in divisors.h).
+// Do NOT use these to store valuable data, as their contents will be overwritten by the functions from this file.
+uint64_t __batch_configuration[BATCH_MAX_N];  // current superstable configuration (the same in every lane; entry 0 is 0)
+uint64_t __batch_divisor[BATCH_MAX_N];        // working divisor (cf. __tmp_divisor)
+uint64_t __batch_done;                        // lane mask of the graphs for which no better divisor can exist
+int __batch_best[BATCH_LANES];
+int __batch_chips_on_v0[BATCH_LANES];
+
+// Dhar's burning algorithm in every lane (cf. burn()). Returns the set of burnt vertices in every lane.
+uint64_t __batch_burn(const graph_batch& B, const uint64_t* divisor, const int start) {
+	uint64_t burnt = __LANE_ONES << start;
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int v = 0; v < B.n; v++) {
+			const uint64_t ignited = (__lane_greater(__lane_popcount(B.adj[v] & burnt), divisor[v]) >> 15) << v;
+			if (ignited & ~burnt) {
+				burnt |= ignited;
+				changed = true;
+			}
+		}
+	}
+	return burnt;
+}
+
+// Fire the given set of vertices in every lane (lanes with an empty set are unchanged).
+void __batch_fire(const graph_batch& B, uint64_t* divisor, const uint64_t firing_set) {
+	for (int v = 0; v < B.n; v++) {
+		const uint64_t fires = ((firing_set >> v) & __LANE_ONES) * 0xFFFF;
+		const uint64_t received = __lane_popcount(B.adj[v] & firing_set);
+		const uint64_t sent = __lane_popcount(B.adj[v] & ~firing_set);
+		divisor[v] = divisor[v] + (received & ~fires) - (sent & fires);
+	}
+}
+
+// Vertices with at least one chip in every lane.
+uint64_t __batch_support(const graph_batch& B, const uint64_t* divisor) {
+	uint64_t support = 0;
+	for (int v = 0; v < B.n; v++) {
+		support |= (__lane_nonzero(divisor[v]) >> 15) << v;
+	}
+	return support;
+}
+
+// Lockstep version of __min_chips_on_v0() for the lanes in the lane mask: compute the smallest c such that
+// the current configuration plus c v0 has positive rank, where c may be at most
+// __batch_best[l] - size - 1 in lane l. The values of c are stored in __batch_chips_on_v0. Returns the lane
+// mask of the lanes in which such a c exists.
+uint64_t __batch_min_chips_on_v0(const graph_batch& B, const int size, uint64_t lanes) {
+	for (int v = 0; v < B.n; v++) {
+		__batch_divisor[v] = (v == 0 ? __LANE_ONES : __batch_configuration[v]);
+	}
+	for (int l = 0; l < BATCH_LANES; l++) {
+		__batch_chips_on_v0[l] = 1;
+	}
+	uint64_t can_reach = __batch_support(B, __batch_divisor);
+	for (int u = 0; u < B.n && lanes; u++) {
+		// Fire towards u in every lane in which u cannot be reached yet (cf. __fire_towards()).
+		uint64_t needed;
+		while ((needed = lanes & ~(((can_reach >> u) & __LANE_ONES) * 0xFFFF)) != 0) {
+			const uint64_t firing_set = ~__batch_burn(B, __batch_divisor, u) & B.vertices & needed;
+			const uint64_t stuck = needed & ~__lane_expand(__lane_nonzero(firing_set));
+			for (int l = 0; l < BATCH_LANES; l++) {
+				if (stuck & __lane_mask(l)) {
+					if (__batch_chips_on_v0[l] == __batch_best[l] - size - 1) {
+						lanes &= ~__lane_mask(l);
+					}
+					else {
+						__batch_chips_on_v0[l]++;
+						__batch_divisor[0] += __LANE_ONES & __lane_mask(l);
+					}
+				}
+			}
+			__batch_fire(B, __batch_divisor, firing_set);
+			can_reach |= __batch_support(B, __batch_divisor);
+		}
+	}
+	return lanes;
+}
+
+// Lockstep version of __one_pass_level(): enumerate the superstable configurations S with |S| = remaining_chips
+// on the vertices finished_vertices, ..., n - 1, in the lanes in the lane mask in which S is superstable.
+void __batch_level(graph_batch& B, const int size, const int remaining_chips, const int finished_vertices, uint64_t lanes) {
+	lanes &= ~__batch_done;
+	if (lanes == 0) {
+		return;
+	}
+	if (remaining_chips == 0 || finished_vertices >= B.n) {
+		if (remaining_chips > 0) {
+			return;
+		}
+		const uint64_t found = __batch_min_chips_on_v0(B, size, lanes);
+		for (int l = 0; l < BATCH_LANES; l++) {
+			if (found & __lane_mask(l)) {
+				__batch_best[l] = size + __batch_chips_on_v0[l];
+				for (int v = 0; v < B.n; v++) {
+					B.divisor[l][v] = (v == 0 ? __batch_chips_on_v0[l] : (int) (__batch_configuration[v] & 0xFFFF));
+				}
+			}
+			if (__batch_best[l] <= size + 1) {
+				__batch_done |= __lane_mask(l);
+			}
+		}
+		return;
+	}
+	for (int i = remaining_chips; i >= 0; i--) {
+		__batch_configuration[finished_vertices] = i * __LANE_ONES;
+		uint64_t superstable = lanes;
+		if (i > 0) {
+			// Keep the lanes in which the partial configuration is superstable (everything burns from v0).
+			superstable &= ~__lane_expand(__lane_nonzero(__batch_burn(B, __batch_configuration, 0) ^ B.vertices));
+		}
+		if (superstable != 0) {
+			__batch_level(B, size, remaining_chips - i, finished_vertices + 1, superstable);
+		}
+	}
+	__batch_configuration[finished_vertices] = 0;
+}
+
+
+
+// Compute the gonality of every graph in the batch (by the same search as find_gonality(); see above).
+//
+// Output values:
+//     * the gonality of the graph in lane l is stored in B.gonality[l];
+//     * the divisor that find_gonality() would return for this graph is stored in B.divisor[l].
+//
+// Changes global variables __batch_configuration, __batch_divisor, __batch_done, __batch_best,
+// __batch_chips_on_v0.
+void solve_batch(graph_batch& B) {
+	assert(B.size >= 1 && B.size <= BATCH_LANES);
+	__batch_done = 0;
+	for (int l = 0; l < BATCH_LANES; l++) {
+		__batch_best[l] = B.n + 1;
+		if (l >= B.size) {
+			__batch_done |= __lane_mask(l);
+		}
+	}
+	for (int v = 0; v < BATCH_MAX_N; v++) {
+		__batch_configuration[v] = 0;
+	}
+	for (int size = 0; __batch_done != ~0ULL; size++) {
+		for (int l = 0; l < B.size; l++) {
+			if (__batch_best[l] <= size + 1) {
+				__batch_done |= __lane_mask(l);
+			}
+		}
+		__batch_level(B, size, size, 1, ~0ULL);
+	}
+	for (int l = 0; l < B.size; l++) {
+		assert(__batch_best[l] <= B.n);
+		B.gonality[l] = __batch_best[l];
+	}
+}
+
+
+
+// Batch scheduler.
+//
+// Graphs are added one by one with add(). Whenever BATCH_WINDOW graphs have been collected, the batchable
+// ones are grouped by number of vertices and solved in batches of BATCH_LANES graphs, and the others are
+// solved by find_gonality(). The function passed to the constructor is called for every graph, with its
+// gonality and an optimal divisor, in the order in which the graphs were added. Call finish() after the
+// last graph to process the remaining ones.
+class batch_scheduler {
+	struct slot {
+		my_graph G;
+		int gonality;
+		std::vector<int> divisor;
+	};
+	slot slots[BATCH_WINDOW];
+	int count;
+	void (*done)(const my_graph&, const int, const int*);
+
+	void run() {
+		graph_batch B;
+		int lane_slot[BATCH_LANES];
+		for (int n = 1; n <= BATCH_MAX_N; n++) {
+			B.init(n);
+			for (int i = 0; i <= count; i++) {
+				if (B.size == BATCH_LANES || (i == count && B.size > 0)) {
+					solve_batch(B);
+					for (int l = 0; l < B.size; l++) {
+						slots[lane_slot[l]].gonality = B.gonality[l];
+						slots[lane_slot[l]].divisor.assign(B.divisor[l], B.divisor[l] + n);
+					}
+					B.init(n);
+				}
+				if (i < count && slots[i].G.n == n && is_batchable(slots[i].G)) {
+					lane_slot[B.add(slots[i].G)] = i;
+				}
+			}
+		}
+		for (int i = 0; i < count; i++) {
+			if (!is_batchable(slots[i].G)) {
+				slots[i].gonality = find_gonality(slots[i].G);
+				slots[i].divisor.assign(__partial_divisor, __partial_divisor + slots[i].G.n);
+			}
+			done(slots[i].G, slots[i].gonality, slots[i].divisor.data());
+		}
+		count = 0;
+	}
+
+public:
+	batch_scheduler(void (*_done)(const my_graph&, const int, const int*)) : count(0), done(_done) {}
+
+	void add(const my_graph& G) {
+		ALLOC_PHASE("graph copy");
+		slot& s = slots[count];
+		s.G.init();
+		s.G.setN(G.n);
+		for (int i = 0; i < G.n; i++) {
+			s.G.neighbours[i] = G.neighbours[i];
+		}
+		s.G.graph_name = G.graph_name;
+		count++;
+		if (count == BATCH_WINDOW) {
+			run();
+		}
+	}
+
+	void finish() {
+		if (count > 0) {
+			run();
+		}
+	}
+};
+
+
+#endif
@@ -0,0 +1,81 @@
+#!/bin/bash
+# Compare the plain build (make), the release build (make release) and the profile-guided build
+# (make pgo) on the benchmark corpus in this directory.
+#
+# Usage (from the main directory):
+#       bench/compare_builds.sh [repetitions]
+#
+# Every benchmark is run the given number of times (default: 5) for every build, and the best wall
+# clock time is reported (in seconds), as a Markdown table. The script also checks that the three
+# builds produce identical output. Afterwards, the programs are rebuilt with the plain build.
+
+set -e
+REPS=${1:-5}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+PROGRAMS="find_gonality subdivision_conjecture verify_gonality"
+BUILDS="plain release pgo"
+
+for build in $BUILDS; do
+	case $build in
+		plain) make -B all > /dev/null 2>&1 ;;
+		release) make release > /dev/null 2>&1 ;;
+		pgo) make pgo > /dev/null 2>&1 ;;
+	esac
+	mkdir "$TMP/$build"
+	cp $PROGRAMS "$TMP/$build/"
+done
+make -B all > /dev/null 2>&1
+
+# Input for verify_gonality: the certificates for bench/graphs.g6, repeated 100 times.
+./find_gonality -gc < bench/graphs.g6 > "$TMP/certificates.txt"
+for i in $(seq 100); do
+	cat "$TMP/certificates.txt"
+done > "$TMP/many_certificates.txt"
+
+BENCHMARKS=(
+	"find_gonality -g < bench/graphs.g6"
+	"find_gonality -g 3 < bench/subdivisions.g6"
+	"find_gonality < bench/multigraphs.txt"
+	"subdivision_conjecture -g < bench/conjecture.g6"
+	"subdivision_conjecture -gf < bench/conjecture.g6"
+	"verify_gonality < $TMP/many_certificates.txt"
+)
+
+# Time a single run of a benchmark (wall clock, in seconds).
+run_time() {
+	local start=$(date +%s.%N)
+	eval "$1" > "$2"
+	local end=$(date +%s.%N)
+	awk -v s="$start" -v e="$end" 'BEGIN { print e - s }'
+}
+
+echo "| Benchmark | plain | release | pgo | pgo speedup vs. plain |"
+echo "|---|---:|---:|---:|---:|"
+for b in "${BENCHMARKS[@]}"; do
+	# The builds take turns, so that fluctuations in the machine load affect all of them alike.
+	for build in $BUILDS; do
+		eval "t_$build=''"
+	done
+	for i in $(seq "$REPS"); do
+		for build in $BUILDS; do
+			t=$(run_time "$TMP/$build/$b" "$TMP/$build.out")
+			eval "t_$build=\"\$t_$build $t\""
+		done
+	done
+	row="| \`${b/$TMP\//}\`"
+	for build in $BUILDS; do
+		eval "times=\$t_$build"
+		best=$(echo $times | awk '{ b = $1; for (i = 2; i <= NF; i++) if ($i < b) b = $i; printf "%.3f", b }')
+		eval "best_$build=$best"
+		row="$row | $best"
+	done
+	for build in release pgo; do
+		if ! cmp -s "$TMP/plain.out" "$TMP/$build.out"; then
+			echo "ERROR: output of the $build build differs for: $b" >&2
+			exit 1
+		fi
+	done
+	speedup=$(awk -v a="$best_plain" -v b="$best_pgo" 'BEGIN { printf "%+.1f%%", 100 * (a - b) / a }')
+	echo "$row | $speedup |"
+done
@@ -0,0 +1,117 @@
+// Gonality certificates.
+//
+// A claim "dgon(G) = d" consists of two halves:
+//
+//      * an upper bound: a positive rank effective divisor D of degree d. This can be checked quickly if,
+//        for every vertex u, we also provide a firing script s_u such that D - L s_u is effective and has
+//        at least one chip on u (here L denotes the Laplacian matrix of G). The scripts computed by reduce()
+//        have exactly this property, because D has positive rank;
+//
+//      * a lower bound: evidence that no positive rank effective divisor of degree d - 1 exists. If d = 1
+//        this is trivial. Otherwise, we record the method that was used to establish the lower bound. For
+//        the brute force search this is a summary of the search tree: the number of divisors of degree
+//        d - 1 that were tried. A checker can confirm that this equals the number of all candidates
+//        (i.e. that the search was complete), but this proves nothing by itself; to check that every
+//        candidate was rejected correctly, the search has to be repeated (verify_gonality -e).
+//
+// A certificate is written as a single line of whitespace-separated tokens:
+//
+//      C n m a_1 b_1 ... a_m b_m D d_0 ... d_{n-1} S s_0(0) ... s_0(n-1) ... s_{n-1}(n-1) L method [data]
+//
+// where (a_i, b_i) are the edges (repeated for parallel edges), d_i are the chips of D, s_u(v) is the number
+// of times vertex v fires in the script for u, and the lower bound method is one of:
+//
+//      trivial             (only allowed when d = 1)
+//      exhaustive <count>  (a complete search over all <count> effective divisors of degree d - 1 with at
+//                           least one chip on vertex 0 found no positive rank divisor; see
+//                           find_positive_rank_divisor() in divisors.h)
+//      scramble <k> <size_1> <vertices of egg 1> ... <size_k> <vertices of egg k>
+//                          (a scramble with k disjoint eggs of order at least d; see scramble.h. This lower
+//                           bound is checked completely, in polynomial time)
+//
+// Lines starting with '#' are comments. Certificates can be checked with the program verify_gonality.
+//
+// The number of candidates in an exhaustive search is computed by count_search_leaves() (see search_ranges.h).
+//
+// This file defines the following functions:
+//
+//      * void print_certificate(std::ostream& os, const my_graph& G, const int* divisor, long long failed_search_leaves, const scramble* S)
+//        Print a certificate for the gonality of G, given an optimal divisor and a lower bound (see above).
+//
+
+#ifndef __CERTIFICATES_H__
+#define __CERTIFICATES_H__
+
+#include "graphs.h"
+#include "divisors.h"
+#include "search_ranges.h"
+#include "scramble.h"
+#include <cassert>
+#include <string>
+#include <ostream>
+
+
+int __script[MAX_N];
+
+
+// Print a gonality certificate (see above) on a single line.
+//
+// Input values:
+//     * the output stream is given as the first input;
+//     * the graph is given as the second input (my_graph data structure; passed by const reference);
+//     * a positive rank effective divisor of minimal degree is given as the third input (C array; passed as
+//       const pointer; this may be __partial_divisor);
+//     * the number of divisors of degree (gonality - 1) that were tried without success is given as the
+//       fourth input (as stored in __failed_search_leaves by find_gonality_by_degree());
+//     * optionally, a scramble of order at least the gonality can be given as the fifth input; it is used as
+//       the lower bound instead of the search.
+//
+// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __tmp_divisor, __script.
+void print_certificate(std::ostream& os, const my_graph& G, const int* divisor, long long failed_search_leaves, const scramble* S = NULL) {
+	int deg = 0;
+	for (int i = 0; i < G.n; i++) {
+		assert(divisor[i] >= 0);
+		deg += divisor[i];
+	}
+	std::string line = "C " + std::to_string(G.n) + ' ' + std::to_string(G.count_edges());
+	for (int i = 0; i < G.n; i++) {
+		for (auto j : G.neighbours[i]) {
+			if (i < j) {
+				line += ' ' + std::to_string(i) + ' ' + std::to_string(j);
+			}
+		}
+	}
+	line += " D";
+	for (int i = 0; i < G.n; i++) {
+		line += ' ' + std::to_string(divisor[i]);
+	}
+	line += " S";
+	for (int u = 0; u < G.n; u++) {
+		reduce(G, divisor, u, __script); // stores the u-reduced divisor D - L s_u in __tmp_divisor
+		assert(__tmp_divisor[u] >= 1);
+		for (int i = 0; i < G.n; i++) {
+			line += ' ' + std::to_string(__script[i]);
+		}
+	}
+	if (deg == 1) {
+		line += " L trivial";
+	}
+	else if (S != NULL) {
+		assert(S->order >= deg);
+		line += " L scramble " + std::to_string(S->eggs.size());
+		for (const std::vector<int>& egg : S->eggs) {
+			line += ' ' + std::to_string(egg.size());
+			for (int v : egg) {
+				line += ' ' + std::to_string(v);
+			}
+		}
+	}
+	else {
+		assert(failed_search_leaves >= 0);
+		line += " L exhaustive " + std::to_string(failed_search_leaves);
+	}
+	os << line << '\n';
+}
+
+
+#endif
@@ -0,0 +1,463 @@
+// Compressed input (gzip and xz).
+//
+// Large inputs (for example the output of geng) are usually stored compressed. Instead of piping them
+// through zcat or xzcat, they can be given to the programs directly: compressed_istream looks at the first
+// byte of the input, and if it starts a gzip or xz file, the input is decompressed on the fly. Other input
+// is read directly from the original stream buffer, exactly as before.
+//
+// The decompressed data is written in chunks directly into the buffers from which the parser reads (the
+// get area of the stream buffer, see decompressing_streambuf below). Decompression runs on separate
+// threads, ahead of the parser:
+//
+//      * xz files are decompressed by the multithreaded decoder of liblzma. Files that consist of several
+//        blocks (as written by "xz -T0") are decompressed in parallel, other files on a single thread;
+//
+//      * gzip files in the BGZF format (as written by bgzip: a sequence of gzip members that each record
+//        their compressed size in the header) are decompressed in parallel, one member per thread;
+//
+//      * other gzip files are decompressed on a single thread. In general, the boundaries between the
+//        members of a gzip file are only known after decompressing them, so they cannot be split up.
+//
+// Concatenated files (several xz streams, or several gzip members) are read completely. Corrupt or
+// truncated input is reported (even if the program is compiled with -DNDEBUG), and the program exits.
+//
+// Programs that include this file should be linked with -lz -llzma. Alternatively, compile with
+// -DNO_COMPRESSED_INPUT to build without zlib and liblzma; compressed input is then rejected.
+//
+// This file defines the following:
+//
+//      * class decompressing_streambuf
+//        Stream buffer that decompresses a gzip or xz file from another stream buffer (see above).
+//
+//      * class compressed_istream
+//        Input stream that reads from another input stream, and decompresses it if needed.
+//
+
+#ifndef __COMPRESSED_INPUT_H__
+#define __COMPRESSED_INPUT_H__
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <streambuf>
+#ifndef NO_COMPRESSED_INPUT
+#include <zlib.h>
+#include <lzma.h>
+#endif
+
+
+const size_t COMPRESSED_INPUT_CHUNK_SIZE = 1 << 18;  // size of the decompressed chunks (except for BGZF members), and of the reads from the compressed input
+const size_t COMPRESSED_INPUT_CHUNKS_PER_THREAD = 4; // number of chunks in flight per decompression thread
+const size_t BGZF_MAX_MEMBER_SIZE = 1 << 16;         // maximum size of a BGZF member (compressed and decompressed)
+
+
+// Corrupt input is reported even if the program is compiled with -DNDEBUG.
+void __compressed_input_error(const char* problem) {
+	std::cerr << "ERROR: invalid compressed input (" << problem << ")." << std::endl;
+	exit(1);
+}
+
+
+// Stream buffer that decompresses a gzip or xz file (see above).
+//
+// The decompressed chunks are stored in a ring. Every chunk is filled by one thread at a time: a producer
+// thread reads the compressed input, and either decompresses it into the next chunk itself, or (for BGZF
+// members) stores the compressed member in the chunk, and leaves the decompression to a worker thread.
+// The reading thread takes the chunks in order, and reads directly from them (see underflow()).
+class decompressing_streambuf : public std::streambuf {
+	enum chunk_state { CHUNK_FREE, CHUNK_FILLING, CHUNK_PENDING, CHUNK_READY };
+	struct chunk {
+		chunk_state state;
+		std::vector<char> in;  // compressed BGZF member (if pending)
+		std::vector<char> out; // decompressed data
+	};
+
+	std::streambuf* raw;
+	std::vector<char> unread; // bytes taken from raw that still have to be processed (front first)
+	std::vector<chunk> chunks;
+	size_t produced;          // number of chunks handed out by the producer
+	size_t consumed;          // number of chunks taken by the reader (the last one is in the get area)
+	std::deque<size_t> pending; // chunks that wait for a worker
+	bool finished;            // the producer is done
+	bool stopping;            // the reader is done (the threads should stop)
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::thread producer;
+	std::vector<std::thread> workers;
+
+	// Read up to len bytes of compressed input. Returns the number of bytes read (less than len only at the
+	// end of the input).
+	size_t read_raw(char* buf, size_t len) {
+		size_t ret = 0;
+		while (ret < len && !unread.empty()) {
+			buf[ret++] = unread.back();
+			unread.pop_back();
+		}
+		while (ret < len) {
+			const std::streamsize n = raw->sgetn(buf + ret, len - ret);
+			if (n <= 0) {
+				break;
+			}
+			ret += n;
+		}
+		return ret;
+	}
+
+	// Put bytes back in front of the compressed input.
+	void unread_raw(const char* buf, size_t len) {
+		for (size_t i = len; i > 0; i--) {
+			unread.push_back(buf[i - 1]);
+		}
+	}
+
+	// Wait for the next chunk in the ring to be free, and hand it to the producer. Returns NULL if the reader
+	// is done.
+	chunk* start_chunk() {
+		std::unique_lock<std::mutex> lock(mutex);
+		chunk& c = chunks[produced % chunks.size()];
+		while (c.state != CHUNK_FREE && !stopping) {
+			cv.wait(lock);
+		}
+		if (stopping) {
+			return NULL;
+		}
+		c.state = CHUNK_FILLING;
+		produced++;
+		return &c;
+	}
+
+	void finish_chunk(chunk* c, chunk_state state) {
+		std::lock_guard<std::mutex> lock(mutex);
+		c->state = state;
+		if (state == CHUNK_PENDING) {
+			pending.push_back(c - chunks.data());
+		}
+		cv.notify_all();
+	}
+
+#ifndef NO_COMPRESSED_INPUT
+	// Decompress a gzip file (any number of members) on the producer thread. Returns false if the reader is done.
+	bool decompress_gzip() {
+		z_stream strm;
+		memset(&strm, 0, sizeof(strm));
+		if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) {
+			__compressed_input_error("cannot initialise zlib");
+		}
+		std::vector<char> in(COMPRESSED_INPUT_CHUNK_SIZE);
+		chunk* c = NULL;
+		bool ok = true, at_member_start = true;
+		while (true) {
+			if (strm.avail_in == 0) {
+				strm.avail_in = read_raw(in.data(), in.size());
+				strm.next_in = (Bytef*) in.data();
+				if (strm.avail_in == 0) {
+					if (!at_member_start) {
+						__compressed_input_error("unexpected end of gzip file");
+					}
+					break;
+				}
+			}
+			if (at_member_start && strm.next_in[0] != 0x1f) {
+				__compressed_input_error("trailing garbage after gzip file");
+			}
+			at_member_start = false;
+			if (c == NULL) {
+				c = start_chunk();
+				if (c == NULL) {
+					ok = false;
+					break;
+				}
+				c->out.resize(COMPRESSED_INPUT_CHUNK_SIZE);
+				strm.next_out = (Bytef*) c->out.data();
+				strm.avail_out = c->out.size();
+			}
+			const int ret = inflate(&strm, Z_NO_FLUSH);
+			if (ret == Z_STREAM_END) {
+				// The next member (if any) starts right after this one.
+				inflateReset(&strm);
+				at_member_start = true;
+			}
+			else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+				__compressed_input_error(strm.msg != NULL ? strm.msg : "corrupt gzip file");
+			}
+			if (strm.avail_out == 0) {
+				finish_chunk(c, CHUNK_READY);
+				c = NULL;
+			}
+		}
+		if (c != NULL) {
+			c->out.resize(c->out.size() - strm.avail_out);
+			finish_chunk(c, CHUNK_READY);
+		}
+		inflateEnd(&strm);
+		return ok;
+	}
+
+	// Read the header of a BGZF member, and return its total size (or 0 if this is not a BGZF member). The
+	// header is put back in front of the input.
+	size_t read_bgzf_header() {
+		unsigned char header[18];
+		const size_t len = read_raw((char*) header, sizeof(header));
+		unread_raw((const char*) header, len);
+		// Fixed part (with the FEXTRA flag set), followed by a single extra subfield "BC" of length 2.
+		if (len < 18 || header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 || (header[3] & 4) == 0
+				|| header[10] != 6 || header[11] != 0 || header[12] != 'B' || header[13] != 'C' || header[14] != 2 || header[15] != 0) {
+			return 0;
+		}
+		return (header[16] | (header[17] << 8)) + 1;
+	}
+
+	// Read the BGZF members, and leave their decompression to the workers. Members without a recorded size
+	// (and whatever follows them) are decompressed by the producer. Returns false if the reader is done.
+	bool decompress_bgzf() {
+		while (true) {
+			const size_t size = read_bgzf_header();
+			if (size == 0) {
+				char byte;
+				if (read_raw(&byte, 1) == 0) {
+					return true;
+				}
+				unread_raw(&byte, 1);
+				return decompress_gzip();
+			}
+			chunk* c = start_chunk();
+			if (c == NULL) {
+				return false;
+			}
+			c->in.resize(size);
+			if (read_raw(c->in.data(), size) != size) {
+				__compressed_input_error("unexpected end of BGZF file");
+			}
+			finish_chunk(c, CHUNK_PENDING);
+		}
+	}
+
+	// Decompress a single BGZF member (worker thread).
+	static void decompress_bgzf_member(chunk& c) {
+		const size_t size = c.in.size();
+		if (size < 26) {
+			__compressed_input_error("BGZF member too short");
+		}
+		const unsigned char* trailer = (const unsigned char*) c.in.data() + size - 4;
+		const size_t decompressed_size = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((size_t) trailer[3] << 24);
+		if (decompressed_size > BGZF_MAX_MEMBER_SIZE) {
+			__compressed_input_error("BGZF member too large");
+		}
+		c.out.resize(decompressed_size);
+		z_stream strm;
+		memset(&strm, 0, sizeof(strm));
+		if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) {
+			__compressed_input_error("cannot initialise zlib");
+		}
+		strm.next_in = (Bytef*) c.in.data();
+		strm.avail_in = size;
+		strm.next_out = (Bytef*) c.out.data();
+		strm.avail_out = decompressed_size;
+		unsigned char spare; // inflate() needs room for output to report the end of an empty member
+		if (decompressed_size == 0) {
+			strm.next_out = &spare;
+			strm.avail_out = 1;
+		}
+		if (inflate(&strm, Z_FINISH) != Z_STREAM_END || strm.avail_in != 0 || strm.total_out != decompressed_size) {
+			__compressed_input_error("corrupt BGZF member");
+		}
+		inflateEnd(&strm);
+	}
+
+	void work() {
+		while (true) {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (pending.empty() && !finished && !stopping) {
+				cv.wait(lock);
+			}
+			if (pending.empty()) {
+				return;
+			}
+			chunk& c = chunks[pending.front()];
+			pending.pop_front();
+			lock.unlock();
+			decompress_bgzf_member(c);
+			finish_chunk(&c, CHUNK_READY);
+		}
+	}
+
+	// Decompress an xz file (any number of streams) with the multithreaded decoder of liblzma.
+	// Returns false if the reader is done.
+	bool decompress_xz(unsigned threads) {
+		lzma_stream strm = LZMA_STREAM_INIT;
+		lzma_mt mt;
+		memset(&mt, 0, sizeof(mt));
+		mt.flags = LZMA_CONCATENATED;
+		mt.threads = threads;
+		const uint64_t physmem = lzma_physmem();
+		mt.memlimit_threading = (physmem > 0 ? physmem / 4 : UINT64_MAX);
+		mt.memlimit_stop = UINT64_MAX;
+		if (lzma_stream_decoder_mt(&strm, &mt) != LZMA_OK) {
+			__compressed_input_error("cannot initialise liblzma");
+		}
+		std::vector<char> in(COMPRESSED_INPUT_CHUNK_SIZE);
+		chunk* c = NULL;
+		bool ok = true;
+		lzma_action action = LZMA_RUN;
+		while (true) {
+			if (strm.avail_in == 0 && action == LZMA_RUN) {
+				strm.avail_in = read_raw(in.data(), in.size());
+				strm.next_in = (const uint8_t*) in.data();
+				if (strm.avail_in == 0) {
+					action = LZMA_FINISH;
+				}
+			}
+			if (c == NULL) {
+				c = start_chunk();
+				if (c == NULL) {
+					ok = false;
+					break;
+				}
+				c->out.resize(COMPRESSED_INPUT_CHUNK_SIZE);
+				strm.next_out = (uint8_t*) c->out.data();
+				strm.avail_out = c->out.size();
+			}
+			const lzma_ret ret = lzma_code(&strm, action);
+			if (ret == LZMA_STREAM_END) {
+				break;
+			}
+			if (ret != LZMA_OK) {
+				__compressed_input_error(ret == LZMA_BUF_ERROR ? "unexpected end of xz file" : "corrupt xz file");
+			}
+			if (strm.avail_out == 0) {
+				finish_chunk(c, CHUNK_READY);
+				c = NULL;
+			}
+		}
+		if (c != NULL) {
+			c->out.resize(c->out.size() - strm.avail_out);
+			finish_chunk(c, CHUNK_READY);
+		}
+		lzma_end(&strm);
+		return ok;
+	}
+#endif
+
+	void produce(unsigned threads) {
+		unsigned char magic[6];
+		const size_t len = read_raw((char*) magic, sizeof(magic));
+		unread_raw((const char*) magic, len);
+#ifdef NO_COMPRESSED_INPUT
+		(void) threads;
+		__compressed_input_error("compiled without support for compressed input");
+#else
+		if (len >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+			decompress_bgzf();
+		}
+		else if (len == 6 && memcmp(magic, "\xfd" "7zXZ\0", 6) == 0) {
+			decompress_xz(threads);
+		}
+		else {
+			__compressed_input_error("unknown file format");
+		}
+#endif
+		std::lock_guard<std::mutex> lock(mutex);
+		finished = true;
+		cv.notify_all();
+	}
+
+protected:
+	// Hand the current chunk back to the producer, and move on to the next one.
+	int_type underflow() override {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			if (consumed > 0) {
+				chunk& previous = chunks[(consumed - 1) % chunks.size()];
+				if (previous.state == CHUNK_READY) {
+					previous.state = CHUNK_FREE;
+					cv.notify_all();
+				}
+			}
+			chunk& c = chunks[consumed % chunks.size()];
+			while (c.state != CHUNK_READY && !(finished && consumed == produced)) {
+				cv.wait(lock);
+			}
+			if (c.state != CHUNK_READY) {
+				setg(NULL, NULL, NULL);
+				return traits_type::eof();
+			}
+			consumed++;
+			if (!c.out.empty()) {
+				setg(c.out.data(), c.out.data(), c.out.data() + c.out.size());
+				return traits_type::to_int_type(c.out[0]);
+			}
+		}
+	}
+
+public:
+	// Decompress the input from the given stream buffer (which should start with a gzip or xz file), using
+	// the given number of threads (or all hardware threads, if this is 0).
+	explicit decompressing_streambuf(std::streambuf* source, unsigned threads = 0)
+			: raw(source), produced(0), consumed(0), finished(false), stopping(false) {
+		if (threads == 0) {
+			threads = std::thread::hardware_concurrency();
+		}
+		if (threads == 0) {
+			threads = 1;
+		}
+		chunks.resize(COMPRESSED_INPUT_CHUNKS_PER_THREAD * (threads + 1));
+		for (chunk& c : chunks) {
+			c.state = CHUNK_FREE;
+		}
+		producer = std::thread(&decompressing_streambuf::produce, this, threads);
+#ifndef NO_COMPRESSED_INPUT
+		for (unsigned i = 0; i < threads; i++) {
+			workers.push_back(std::thread(&decompressing_streambuf::work, this));
+		}
+#endif
+	}
+
+	~decompressing_streambuf() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+			cv.notify_all();
+		}
+		producer.join();
+		for (std::thread& t : workers) {
+			t.join();
+		}
+	}
+};
+
+
+// Input stream that reads from the given input stream, and decompresses it if it starts with a gzip or xz
+// file (see above). Otherwise, it reads directly from the stream buffer of the given stream. Blocks until
+// the first byte of the input is available. The given stream should not be used directly afterwards.
+class compressed_istream : public std::istream {
+	decompressing_streambuf* decompressor;
+
+public:
+	explicit compressed_istream(std::istream& source) : std::istream(source.rdbuf()), decompressor(NULL) {
+		tie(source.tie());
+		const int c = source.rdbuf()->sgetc();
+		if (c == 0x1f || c == 0xfd) {
+			decompressor = new decompressing_streambuf(source.rdbuf());
+			rdbuf(decompressor);
+		}
+	}
+
+	// Whether the input is being decompressed.
+	bool is_compressed() const {
+		return decompressor != NULL;
+	}
+
+	~compressed_istream() {
+		delete decompressor;
+	}
+};
+
+
+#endif
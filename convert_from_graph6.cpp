@@ -11,6 +11,7 @@
 #include "graphs.h"
 #include "graph6.h"
 #include "graph_io.h"
+#include "compressed_input.h"
 #include <iostream>
 #include <cassert>
 #include <algorithm>
@@ -32,8 +33,9 @@ void parseGraph(const string& s) {
 }
 
 int main() {
+	compressed_istream input(cin);
 	string s;
-	while (getline(cin, s)) {
+	while (getline(input, s)) {
 		parseGraph(s);
 	}
 	return 0;
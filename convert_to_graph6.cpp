@@ -19,6 +19,7 @@
 #include "subdivisions.h"
 #include "graph_io.h"
 #include "graph6.h"
+#include "compressed_input.h"
 #include <iostream>
 #include <cassert>
 #include <cstdio>
@@ -32,7 +33,9 @@ void solve(const my_graph& G) {
 	assert(G.is_valid_undirected_graph());
 	assert(subdiv_num == -1 || (subdiv_num >= 2 && subdiv_num <= MAX_PARTS_PER_EDGE));
 	my_graph H = (subdiv_num == -1 ? G : subdivide(G, subdiv_num));
-	assert(H.is_valid_undirected_graph()); // check validy AND populate __adj_matr[][]
+	bool valid = H.is_valid_undirected_graph(); // check validy AND populate __adj_matr[][] (not inside assert(), which disappears with -DNDEBUG)
+	assert(valid);
+	(void) valid;
 	for (int i = 0; i < H.n; i++) {
 		for (int j = 0; j < H.n; j++) {
 			assert(__adj_matr[i][j] >= 0);
@@ -85,7 +88,8 @@ int main(int argc, char* argv[]) {
 		print_usage(argv[0]);
 	}
 	assert(subdiv_num == -1 || (subdiv_num >= 2 && subdiv_num <= MAX_PARTS_PER_EDGE));
-	read_plain_input_and_process(cin, solve);
+	compressed_istream input(cin);
+	read_plain_input_and_process(input, solve);
 	return 0;
 }
 
@@ -5,6 +5,9 @@
 //      * int burn(const my_graph& G, const int* divisor, const int start)
 //        Dhar's burning algorithm.
 //      
+//      * uint64_t multi_burn(const my_graph& G, const int* divisor, const int* starts, const int num_starts)
+//        Dhar's burning algorithm from up to 64 start vertices at once (bit-sliced).
+//      
 //      * bool is_reduced(const my_graph& G, const int* divisor, const int target = -1)
 //        Test whether a divisor is reduced with respect to a given vertex or with respect to any vertex.
 //	
@@ -20,8 +23,11 @@
 //	* void find_all_positive_rank_v0_reduced_divisors(const my_graph& G, const int remaining_chips, void (*const fn)(), const int finished_vertices = 0)
 //        Brute force search for ALL positive rank v0-reduced divisors of prescribed degree. Somewhat optimized for performance.
 //	
-//      * int find_gonality(const my_graph& G)
-//        Determine the (divisorial) gonality of G by brute force search.
+//      * int find_gonality(const my_graph& G, const int max_degree = MAX_N, const int lower_bound = 1)
+//        Determine the (divisorial) gonality of G by a single branch-and-bound pass over the superstable configurations.
+//	
+//      * int find_gonality_by_degree(const my_graph& G, const int max_degree = MAX_N, const int lower_bound = 1)
+//        Determine the (divisorial) gonality of G by brute force search, trying degrees 1, 2, 3, ... in turn.
 // 
 
 #ifndef __DIVISORS_H__
@@ -29,19 +35,36 @@
 
 
 #include <cassert>
+#include <cstdint>
 #include <queue>
+#include <vector>
 #include "graphs.h"
+#include "alloc_stats.h"
 
 
 
 // Global variables.
 // Do NOT use these to store valuable data, as their contents will be overwritten by the functions from this file.
-bool __pushed_to_queue[MAX_N];
-int __burnt_edges[MAX_N];
-int __firing_set[MAX_N];
-int __partial_divisor[MAX_N];
-int __tmp_divisor[MAX_N];
-bool __can_reach[MAX_N];
+// They are thread-local, so the functions from this file can be used by several threads at once (e.g. by
+// hybrid_scheduler.h), as long as the threads do not call G.is_valid_undirected_graph() (which writes to
+// the global adjacency matrix in graphs.h); the assertions that do so should run on a single thread.
+thread_local bool __pushed_to_queue[MAX_N];
+thread_local int __burnt_edges[MAX_N];
+thread_local int __firing_set[MAX_N];
+thread_local int __partial_divisor[MAX_N];
+thread_local int __tmp_divisor[MAX_N];
+thread_local bool __can_reach[MAX_N];
+
+// Search statistics.
+// These are only written by the functions in this file (and may be read by the caller afterwards).
+thread_local long long __search_leaves = 0;        // number of divisors of the requested degree tried by the last call to find_positive_rank_divisor()
+thread_local long long __failed_search_leaves = 0; // number of divisors of degree (gonality - 1) tried by the last call to find_gonality()
+
+// Optional alternative implementation of has_positive_rank() for large graphs (installed by parallel_rank.h).
+// It is used for graphs with at least __parallel_rank_min_n vertices, and returns 1 (positive rank),
+// 0 (rank 0), or -1 (not available right now; use the sequential algorithm instead).
+int (*__parallel_has_positive_rank)(const my_graph&, const int*) = NULL;
+int __parallel_rank_min_n = MAX_N + 1;
 
 
 
@@ -58,6 +81,7 @@ bool __can_reach[MAX_N];
 // 
 // Changes global variables __pushed_to_queue, __burnt_edges, __firing_set.
 int burn(const my_graph& G, const int* divisor, const int start) {
+	ALLOC_PHASE("burn");
 	assert(start >= 0 && start < G.n);
 	for (int i = 0; i < G.n; i++) {
 		__pushed_to_queue[i] = false;
@@ -90,6 +114,125 @@ int burn(const my_graph& G, const int* divisor, const int start) {
 
 
 
+// Dhar's burning algorithm from several start vertices at once.
+// 
+// The burns from up to MULTI_BURN_LANES start vertices are carried out simultaneously, one in every bit
+// lane of a 64-bit word. The number of burnt edges towards every vertex is kept in bit-sliced form (the
+// k-th bits of the counters of all lanes form one word), so a burning vertex updates the counters of its
+// neighbours in all lanes with a few word operations, and every vertex is processed once for every
+// batch of lanes in which it catches fire. In practice, a sweep over 64 start vertices costs about as
+// many passes over the adjacency lists as a single call to burn().
+// 
+// Input values:
+//     * the graph is given as the first input (my_graph data structure; passed by const reference);
+//     * the divisor is given as the second input (C array; passed as const pointer);
+//     * the starting vertices are given as the third input (C array; passed as const pointer), and their
+//       number (between 1 and MULTI_BURN_LANES) as the fourth input. Lane s burns from starts[s].
+// 
+// Output values:
+//     * bit s of __multi_burnt[v] indicates whether v burns in lane s (so the firing set of lane s
+//       consists of the vertices whose bit s is not set);
+//     * the return value has bit s set if the firing set of lane s is empty (i.e. if the divisor is
+//       reduced with respect to starts[s]).
+// 
+// Changes global variables __pushed_to_queue, __multi_burnt, __multi_burning, __multi_queue, __multi_chips, __multi_counters.
+const int MULTI_BURN_LANES = 64;
+thread_local uint64_t __multi_burnt[MAX_N];
+thread_local uint64_t __multi_burning[MAX_N];          // lanes in which the vertex caught fire, but has not been processed yet
+thread_local int __multi_queue[MAX_N];
+thread_local int __multi_chips[MAX_N];                // number of chips (-1 if the vertex cannot catch fire)
+thread_local std::vector<uint64_t> __multi_counters;   // bit planes of the burnt edge counters (planes words per vertex)
+
+uint64_t multi_burn(const my_graph& G, const int* divisor, const int* starts, const int num_starts) {
+	ALLOC_PHASE("burn");
+	assert(num_starts >= 1 && num_starts <= MULTI_BURN_LANES);
+	for (int i = 0; i < G.n; i++) {
+		__pushed_to_queue[i] = false;
+		__multi_burnt[i] = 0;
+		__multi_burning[i] = 0;
+	}
+	int head = 0, size = 0;
+	for (int s = 0; s < num_starts; s++) {
+		const int v = starts[s];
+		assert(v >= 0 && v < G.n);
+		__multi_burnt[v] |= uint64_t(1) << s;
+		__multi_burning[v] |= uint64_t(1) << s;
+		if (!__pushed_to_queue[v]) {
+			__pushed_to_queue[v] = true;
+			__multi_queue[size++] = v;
+		}
+	}
+	// A vertex catches fire when its counter exceeds its number of chips, so the counters need enough bit
+	// planes to count up to divisor[v] + 1 (except for vertices with at least as many chips as edges,
+	// which never catch fire). Negative entries only occur on start vertices, and behave like 0 in the
+	// other lanes (as in burn()).
+	int planes = 0;
+	for (int i = 0; i < G.n; i++) {
+		assert(__multi_burnt[i] != 0 || divisor[i] >= 0);
+		__multi_chips[i] = (divisor[i] > 0 ? divisor[i] : 0);
+		if (__multi_chips[i] < (int) G.neighbours[i].size()) {
+			while ((1 << planes) <= __multi_chips[i] + 1) {
+				planes++;
+			}
+		}
+		else {
+			__multi_chips[i] = -1;
+		}
+	}
+	std::vector<uint64_t>& counters = __multi_counters;
+	counters.assign(G.n * planes, 0);
+	while (size > 0) {
+		const int i = __multi_queue[head];
+		head = (head + 1 == G.n ? 0 : head + 1);
+		size--;
+		__pushed_to_queue[i] = false;
+		const uint64_t lanes = __multi_burning[i];
+		__multi_burning[i] = 0;
+		for (auto j : G.neighbours[i]) {
+			const uint64_t active = lanes & ~__multi_burnt[j];
+			const int chips = __multi_chips[j];
+			if (active == 0 || chips < 0) {
+				continue;
+			}
+			// Add 1 to the counters in the active lanes, then compare them with the number of chips (from
+			// the most significant bit down).
+			uint64_t* c = &counters[j * planes];
+			uint64_t carry = active;
+			for (int k = 0; k < planes && carry != 0; k++) {
+				const uint64_t t = c[k] & carry;
+				c[k] ^= carry;
+				carry = t;
+			}
+			uint64_t greater = 0, equal = active;
+			for (int k = planes - 1; k >= 0; k--) {
+				if ((chips >> k) & 1) {
+					equal &= c[k];
+				}
+				else {
+					greater |= equal & c[k];
+					equal &= ~c[k];
+				}
+			}
+			if (greater != 0) {
+				__multi_burnt[j] |= greater;
+				__multi_burning[j] |= greater;
+				if (!__pushed_to_queue[j]) {
+					__pushed_to_queue[j] = true;
+					__multi_queue[(head + size) % G.n] = j;
+					size++;
+				}
+			}
+		}
+	}
+	uint64_t ret = (num_starts == MULTI_BURN_LANES ? ~uint64_t(0) : (uint64_t(1) << num_starts) - 1);
+	for (int i = 0; i < G.n; i++) {
+		ret &= __multi_burnt[i];
+	}
+	return ret;
+}
+
+
+
 // Determine whether a given divisor is reduced with respect to a given vertex (use third argument)
 // or with respect to any vertex (omit third argument).
 // 
@@ -101,12 +244,27 @@ int burn(const my_graph& G, const int* divisor, const int start) {
 // Output values:
 //     * a boolean indicating whether or not the given divisor is reduced.
 // 
-// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set.
+// Without a target vertex, the burns from the vertices other than v0 are carried out MULTI_BURN_LANES at
+// a time by multi_burn().
+// 
+// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, and without a target vertex
+// also __multi_burnt, __multi_burning, __multi_queue, __multi_chips, __multi_counters.
 bool is_reduced(const my_graph& G, const int* divisor, const int target = -1) {
 	assert(target >= -1 && target < G.n);
 	if (target == -1) {
-		for (int i = 0; i < G.n; i++) {
-			if (burn(G, divisor, i) == 0) {
+		// Most divisors that are reduced with respect to some vertex are reduced with respect to many, so a
+		// single burn often suffices.
+		if (burn(G, divisor, 0) == 0) {
+			return true;
+		}
+		int starts[MULTI_BURN_LANES];
+		for (int first = 1; first < G.n; first += MULTI_BURN_LANES) {
+			int num_starts = 0;
+			while (num_starts < MULTI_BURN_LANES && first + num_starts < G.n) {
+				starts[num_starts] = first + num_starts;
+				num_starts++;
+			}
+			if (multi_burn(G, divisor, starts, num_starts) != 0) {
 				return true;
 			}
 		}
@@ -165,6 +323,33 @@ void reduce(const my_graph& G, const int* divisor, const int target, int* script
 
 
 
+// Helper function for has_positive_rank(): fire from __tmp_divisor towards u until u receives a chip.
+// Returns false if this is impossible (i.e. if the u-reduced divisor has no chip on u).
+bool __fire_towards(const my_graph& G, const int u) {
+	while (!__can_reach[u]) {
+		int firing_set_size = burn(G, __tmp_divisor, u);
+		if (firing_set_size == 0) {
+			return false;
+		}
+		for (int j = 0; j < firing_set_size; j++) {
+			int v = __firing_set[j];
+			for (auto w : G.neighbours[v]) {
+				__tmp_divisor[v]--;
+				__tmp_divisor[w]++;
+			}
+		}
+		// record intermediate steps to save time
+		for (int v = 0; v < G.n; v++) {
+			if (__tmp_divisor[v] > 0) {
+				__can_reach[v] = true;
+			}
+		}
+	}
+	return true;
+}
+
+
+
 // Test whether a given divisor has positive rank.
 // 
 // Input values:
@@ -177,35 +362,31 @@ void reduce(const my_graph& G, const int* divisor, const int target, int* script
 // Output values:
 //     * the return value is a boolean indicating whether or not the divisor has positive rank.
 // 
+// For every target vertex u, the divisor is fired towards u until u receives a chip. All intermediate
+// divisors are equivalent to the input, so the work done for one target is reused for the next one.
+// 
+// If a parallel implementation has been installed (see parallel_rank.h) and the graph is large enough,
+// the work is handed off to this implementation, which does not change any of the global variables.
+// 
 // Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __tmp_divisor, __can_reach.
 bool has_positive_rank(const my_graph& G, const int* divisor, bool check_graph_validity = true) {
 	if (check_graph_validity) {
 		assert(G.is_valid_undirected_graph());
 	}
+	if (G.n >= __parallel_rank_min_n && __parallel_has_positive_rank != NULL) {
+		int ret = __parallel_has_positive_rank(G, divisor);
+		if (ret != -1) {
+			return ret;
+		}
+	}
 	for (int i = 0; i < G.n; i++) {
 		assert(divisor[i] >= 0);
 		__tmp_divisor[i] = divisor[i];
 		__can_reach[i] = (divisor[i] > 0);
 	}
 	for (int u = 0; u < G.n; u++) {
-		while (!__can_reach[u]) {
-			int firing_set_size = burn(G, __tmp_divisor, u);
-			if (firing_set_size == 0) {
-				return false;
-			}
-			for (int j = 0; j < firing_set_size; j++) {
-				int v = __firing_set[j];
-				for (auto w : G.neighbours[v]) {
-					__tmp_divisor[v]--;
-					__tmp_divisor[w]++;
-				}
-			}
-			// record intermediate steps to save time
-			for (int v = 0; v < G.n; v++) {
-				if (__tmp_divisor[v] > 0) {
-					__can_reach[v] = true;
-				}
-			}
+		if (!__fire_towards(G, u)) {
+			return false;
 		}
 	}
 	return true;
@@ -225,9 +406,10 @@ bool has_positive_rank(const my_graph& G, const int* divisor, bool check_graph_v
 // 
 // Output values:
 //     * the return value is a boolean indicating whether or not a positive rank divisor was found;
-//     * in case of success, the found divisor is stored in the global variable __partial_divisor.
+//     * in case of success, the found divisor is stored in the global variable __partial_divisor;
+//     * the number of divisors of the requested degree that were tried is stored in __search_leaves.
 // 
-// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __partial_divisor, __tmp_divisor, __can_reach.
+// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __partial_divisor, __tmp_divisor, __can_reach, __search_leaves.
 bool find_positive_rank_divisor(const my_graph& G, const int remaining_chips, const int finished_vertices = 0) {
 	assert(remaining_chips >= 0);
 	assert(finished_vertices >= 0 && finished_vertices <= G.n);
@@ -235,6 +417,7 @@ bool find_positive_rank_divisor(const my_graph& G, const int remaining_chips, co
 		// Sanity check. Only carried out once at the very beginning, when finished_vertices == 0.
 		// (Other initializations should also go here.)
 		assert(G.is_valid_undirected_graph());
+		__search_leaves = 0;
 	}
 	if (finished_vertices >= G.n) {
 		// Found a divisor defined on all of G. Don't recurse any further.
@@ -246,6 +429,7 @@ bool find_positive_rank_divisor(const my_graph& G, const int remaining_chips, co
 		// Note: logical and (&&) statements in C++ are short-circuiting, so the tests are carried out
 		// from left to right and aborted as soon as any one of them returns false. This is especially
 		// important because calls to the function has_positive_rank() dictate the total runtime.
+		__search_leaves += (remaining_chips == 0);
 		return remaining_chips == 0 && __partial_divisor[0] > 0 && burn(G, __partial_divisor, 0) == 0 && has_positive_rank(G, __partial_divisor, false);
 	}
 	
@@ -338,24 +522,207 @@ void find_all_positive_rank_v0_reduced_divisors(const my_graph& G, const int rem
 
 
 
-// Determine the (divisorial) gonality by brute force search.
+// Determine the (divisorial) gonality by brute force search, trying degrees 1, 2, 3, ... in turn.
+// 
+// This is the original algorithm; find_gonality() below is usually faster. This function is kept because
+// its search summary is used for gonality certificates (see certificates.h), and as a reference.
 // 
 // Input values:
-//     * the graph is given as the first and only input (my_graph data structure; passed by const reference).
+//     * the graph is given as the first input (my_graph data structure; passed by const reference);
+//     * optionally, the maximum degree to try can be given as the second input;
+//     * optionally, a known lower bound for the gonality (e.g. from scramble.h) can be given as the third
+//       input; the degrees below it are skipped.
 // 
 // Output values:
-//     * the gonality of the graph is returned;
-//     * a positive rank effective divisor of minimal degree is stored in the global variable __partial_divisor.
+//     * the gonality of the graph is returned (or -1 if it is larger than the given maximum degree);
+//     * a positive rank effective divisor of minimal degree is stored in the global variable __partial_divisor;
+//     * the number of divisors of degree (gonality - 1) that were tried without success is stored in
+//       __failed_search_leaves (this serves as a summary of the lower bound; see certificates.h). If the
+//       gonality equals the given lower bound, this search is skipped, and __failed_search_leaves is 0.
 // 
-// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __partial_divisor, __tmp_divisor, __can_reach.
-int find_gonality(const my_graph& G) {
+// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __partial_divisor, __tmp_divisor, __can_reach, __search_leaves, __failed_search_leaves.
+int find_gonality_by_degree(const my_graph& G, const int max_degree = MAX_N, const int lower_bound = 1) {
 	assert(G.is_valid_undirected_graph());
-	for (int deg = 1; true; deg++) {
+	assert(max_degree >= 1 && lower_bound >= 1);
+	__failed_search_leaves = 0;
+	for (int deg = lower_bound; deg <= max_degree; deg++) {
 		if (find_positive_rank_divisor(G, deg)) {
 			return deg;
 		}
+		__failed_search_leaves = __search_leaves;
 		assert(deg <= G.n);
 	}
+	return -1;
+}
+
+
+
+// One-pass gonality computation (used by find_gonality() below).
+// 
+// Every divisor is equivalent to a unique v0-reduced divisor, which is of the form S + c v0, where S is a
+// superstable configuration on the vertices other than v0 (i.e. S + 0 v0 is v0-reduced) and c >= 0. Moreover,
+// S + c v0 can only have positive rank if c >= 1. Hence the gonality is the minimum of |S| + c over all
+// superstable S and all c such that S + c v0 has positive rank.
+// 
+// The degree loop in find_gonality_by_degree() considers every such S once for every degree, and retries
+// every c. Here, every superstable S is enumerated once, in order of increasing |S|, and the smallest c
+// is computed directly: starting from S + v0, the divisor is fired towards every target in turn (as in
+// has_positive_rank()), and whenever a target cannot be reached, a chip is added on v0. Such a chip is
+// necessary (the current c is too small), and adding it preserves all reachability found so far, so the
+// final number of chips on v0 is the minimal c. With the best value found so far (initially n + 1, as the
+// divisor with one chip on every vertex has positive rank), the computation of c is aborted as soon as
+// |S| + c is no better, and the enumeration stops once |S| + 1 is no better.
+// 
+// Superstable configurations are closed under taking smaller configurations, so the enumeration can skip
+// every extension of a partial configuration that is not superstable.
+thread_local int __one_pass_best;
+thread_local int __one_pass_best_divisor[MAX_N];
+thread_local int __one_pass_lower_bound = 1; // the search stops as soon as a divisor of this degree is found
+
+// Optional limit on the number of leaves (used by hybrid_scheduler.h): once __search_leaves reaches
+// __one_pass_leaf_limit, __one_pass_level() stops and sets __one_pass_aborted. A negative limit means no limit.
+thread_local long long __one_pass_leaf_limit = -1;
+thread_local bool __one_pass_aborted = false;
+
+// Variant of __min_chips_on_v0() below for the parallel implementation of has_positive_rank() (see
+// parallel_rank.h). Adding chips preserves positive rank, so the smallest c is found by a binary search,
+// starting with c = max_c (which rejects most configurations with a single call). Returns -2 if the
+// parallel implementation is not available right now.
+int __min_chips_on_v0_parallel(const my_graph& G, const int max_c) {
+	for (int i = 0; i < G.n; i++) {
+		__tmp_divisor[i] = (i == 0 ? max_c : __partial_divisor[i]);
+	}
+	int ret = __parallel_has_positive_rank(G, __tmp_divisor);
+	if (ret != 1) {
+		return (ret == 0 ? -1 : -2);
+	}
+	int lo = 0, hi = max_c; // S + lo v0 has rank 0 (it is v0-reduced without chips on v0), S + hi v0 has positive rank
+	while (hi - lo > 1) {
+		__tmp_divisor[0] = (lo + hi) / 2;
+		ret = __parallel_has_positive_rank(G, __tmp_divisor);
+		if (ret == -1) {
+			return -2;
+		}
+		if (ret == 1) {
+			hi = __tmp_divisor[0];
+		}
+		else {
+			lo = __tmp_divisor[0];
+		}
+	}
+	return hi;
+}
+
+// Compute the smallest c <= max_c such that the configuration in __partial_divisor (ignoring vertex 0)
+// plus c v0 has positive rank. Returns this c, or -1 if no such c exists.
+// 
+// If a parallel implementation of has_positive_rank() has been installed (see parallel_rank.h) and the graph
+// is large enough, the computation is handed off to __min_chips_on_v0_parallel() (as in has_positive_rank()).
+int __min_chips_on_v0(const my_graph& G, const int max_c) {
+	assert(max_c >= 1);
+	if (G.n >= __parallel_rank_min_n && __parallel_has_positive_rank != NULL) {
+		const int c = __min_chips_on_v0_parallel(G, max_c);
+		if (c != -2) {
+			return c;
+		}
+	}
+	for (int i = 0; i < G.n; i++) {
+		__tmp_divisor[i] = (i == 0 ? 1 : __partial_divisor[i]);
+		__can_reach[i] = (__tmp_divisor[i] > 0);
+	}
+	int c = 1;
+	for (int u = 0; u < G.n; u++) {
+		while (!__fire_towards(G, u)) {
+			if (c == max_c) {
+				return -1;
+			}
+			c++;
+			__tmp_divisor[0]++;
+			__can_reach[0] = true;
+		}
+	}
+	return c;
+}
+
+// Enumerate the superstable configurations S with |S| = remaining_chips on the vertices finished_vertices,
+// ..., n - 1 (the vertices 1, ..., finished_vertices - 1 are already set in __partial_divisor, and the other
+// entries are 0). Returns true if the search can stop (no better divisor can exist).
+bool __one_pass_level(const my_graph& G, const int size, const int remaining_chips, const int finished_vertices) {
+	if (remaining_chips == 0 || finished_vertices >= G.n) {
+		if (remaining_chips > 0) {
+			return false;
+		}
+		if (__search_leaves == __one_pass_leaf_limit) {
+			__one_pass_aborted = true;
+			return true;
+		}
+		__search_leaves++;
+		const int c = __min_chips_on_v0(G, __one_pass_best - size - 1);
+		if (c != -1) {
+			__one_pass_best = size + c;
+			for (int i = 0; i < G.n; i++) {
+				__one_pass_best_divisor[i] = (i == 0 ? c : __partial_divisor[i]);
+			}
+		}
+		return __one_pass_best <= size + 1 || __one_pass_best <= __one_pass_lower_bound;
+	}
+	for (int i = remaining_chips; i >= 0; i--) {
+		__partial_divisor[finished_vertices] = i;
+		// Test whether the partial configuration is superstable (only needed if it has changed).
+		if (i == 0 || burn(G, __partial_divisor, 0) == 0) {
+			if (__one_pass_level(G, size, remaining_chips - i, finished_vertices + 1)) {
+				__partial_divisor[finished_vertices] = 0;
+				return true;
+			}
+		}
+	}
+	__partial_divisor[finished_vertices] = 0;
+	return false;
+}
+
+
+
+// Determine the (divisorial) gonality by a single branch-and-bound pass over the superstable configurations
+// (see above).
+// 
+// Input values:
+//     * the graph is given as the first input (my_graph data structure; passed by const reference);
+//     * optionally, the maximum degree to try can be given as the second input (this is used as the initial
+//       bound in the branch-and-bound search);
+//     * optionally, a known lower bound for the gonality (e.g. from scramble.h) can be given as the third
+//       input; the search stops as soon as a divisor of this degree is found (this is the same divisor as
+//       without the lower bound).
+// 
+// Output values:
+//     * the gonality of the graph is returned (or -1 if it is larger than the given maximum degree);
+//     * a v0-reduced positive rank effective divisor of minimal degree is stored in the global variable
+//       __partial_divisor (this is not necessarily the same divisor as the one found by find_gonality_by_degree());
+//     * the number of superstable configurations that were tried is stored in __search_leaves.
+// 
+// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __partial_divisor, __tmp_divisor, __can_reach, __search_leaves.
+int find_gonality(const my_graph& G, const int max_degree = MAX_N, const int lower_bound = 1) {
+	assert(G.is_valid_undirected_graph());
+	assert(max_degree >= 1 && lower_bound >= 1);
+	__search_leaves = 0;
+	__one_pass_lower_bound = lower_bound;
+	__one_pass_best = (max_degree < G.n ? max_degree : G.n) + 1;
+	for (int i = 0; i < G.n; i++) {
+		__partial_divisor[i] = 0;
+	}
+	for (int size = 0; size + 1 < __one_pass_best && __one_pass_best > lower_bound; size++) {
+		if (__one_pass_level(G, size, size, 1)) {
+			break;
+		}
+	}
+	__one_pass_lower_bound = 1;
+	if (__one_pass_best > max_degree) {
+		return -1;
+	}
+	assert(__one_pass_best <= G.n);
+	for (int i = 0; i < G.n; i++) {
+		__partial_divisor[i] = __one_pass_best_divisor[i];
+	}
+	return __one_pass_best;
 }
 
 
@@ -1,7 +1,7 @@
 // This program reads a bunch of graphs from standard input, and computes their gonality.
 // 
 // Usage:
-//       ./find_gonality [-gavv] [k] < infile.in
+//       ./find_gonality [-gpibtscavv] [-j threads] [-R threads] [-d degree [-r part/parts]] [k] < infile.in
 // 
 //       Numerical argument k: if this is specified, the program will take the k-regular
 //                             subdivision of every graph before computing the gonality.
@@ -11,8 +11,41 @@
 // 
 //       Input options:
 //       -g  : use graph6 input instead of plain input
+//       -p  : pipelined I/O (read, solve and write on separate threads; see pipeline.h)
+// 
+//       Computational options:
+//       -i  : interleave the computations for several graphs in time slices, so that easy graphs
+//             are not held up by hard ones (see resumable_search.h; cannot be combined with -a). This
+//             runs the same one-pass search as the default mode, so the output is the same, except
+//             that with -c, the certificate may show a different divisor (-c without -i uses the
+//             degree loop find_gonality_by_degree(), which is faster when the search at degree
+//             gonality - 1 is needed anyway)
+//       -t  : choose the fastest engine for every graph by short probing runs, and report it
+//             (see autotune.h; cannot be combined with -a, -c or -i; with -v, also show the probe times)
+//       -b  : compute the gonality of simple graphs on at most 16 vertices in batches of 4 graphs
+//             (see batched_kernels.h; cannot be combined with -a, -c, -i or -t)
+//       -j N: compute the gonality of several graphs at once on N threads, and split the search for
+//             hard graphs over the threads (see hybrid_scheduler.h; cannot be combined with -a, -c, -i,
+//             -t, -b or -p; the parallel positive rank test is not used then; prints statistics on
+//             standard error at the end)
+//       -R N: use N threads for the positive rank test on graphs with at least PARALLEL_RANK_MIN_N
+//             vertices (see parallel_rank.h; default: the number of hardware threads; -R 1 disables
+//             the parallel test, e.g. when several processes share a machine; cannot be combined with -j)
+//       -s  : first look for a scramble (see scramble.h; at most SCRAMBLE_RUNS runs, aiming for the
+//             upper bound from gonality_upper_bound()), and skip the degrees below its order; with -c,
+//             compute the gonality first, look for a scramble of that order, and use it as the lower
+//             bound in the certificate if one is found (cannot be combined with -i, -t, -b or -j; with
+//             -v, also show the order of the scramble)
+//       -d D: instead of computing the gonality, only search for a positive rank divisor of degree D
+//             (cannot be combined with -a, -c, -i, -t, -b, -j or -s)
+//       -r I/N: with -d, divide the search at degree D into N ranges of candidates of equal size (see
+//             search_ranges.h), and only search range I (0 <= I < N). The ranges can be searched by
+//             different processes or jobs: the gonality is at most D if and only if one of them finds a
+//             positive rank divisor. The exact progress within the range is shown on standard error.
 // 
 //       Output options:
+//       -c  : print a gonality certificate for every graph instead of the usual output
+//             (see certificates.h; these can be checked with verify_gonality)
 //       -a  : find (and show) all optimal v0-reduced divisors
 //       -v  : verbose (show the optimal v0-reduced divisor)
 //       -vv : extra verbose (show the reduced divisor for every vertex in the graph)
@@ -30,10 +63,13 @@
 // 
 // Use the auxiliary programs convert_[to/from]_graph6 to convert between the plain format
 // and the graph6 format.
+// 
+// Input (in either format) may also be compressed with gzip or xz; this is detected automatically
+// (see compressed_input.h).
 
 
 #define USAGE_STRING \
-"find_gonality [-gavv] [k] < infile.in"
+"find_gonality [-gpibtscavv] [-j threads] [-R threads] [-d degree [-r part/parts]] [k] < infile.in"
 
 #define HELPTEXT \
 " Find the gonality of the graphs specified in the file \"infile.in\".\n\
@@ -44,8 +80,29 @@
 \n\
     Input options:\n\
        -g    : use graph6 input instead of plain input\n\
+       -p    : pipelined I/O (read, solve and write on separate threads)\n\
+\n\
+    Computational options:\n\
+       -i    : interleave the computations for several graphs in time slices\n\
+               (cannot be combined with -a)\n\
+       -t    : choose the fastest engine for every graph by short probing runs,\n\
+               and report it (cannot be combined with -a, -c or -i)\n\
+       -b    : compute the gonality of small simple graphs in batches\n\
+               (cannot be combined with -a, -c, -i or -t)\n\
+       -j N  : use N threads, splitting the search for hard graphs over them\n\
+               (cannot be combined with -a, -c, -i, -t, -b or -p)\n\
+       -R N  : use N threads for the positive rank test on large graphs\n\
+               (default: all hardware threads; -R 1 disables it; cannot be combined with -j)\n\
+       -s    : start the search at the order of a scramble, found by a short heuristic\n\
+               search (cannot be combined with -i, -t, -b or -j)\n\
+       -d D  : only search for a positive rank divisor of degree D\n\
+               (cannot be combined with -a, -c, -i, -t, -b, -j or -s)\n\
+       -r I/N: with -d, only search range I of the N equal ranges of candidates\n\
+               (0 <= I < N), showing the progress on standard error\n\
 \n\
     Output options:\n\
+       -c    : print a gonality certificate for every graph instead of the usual output\n\
+               (these can be checked with verify_gonality)\n\
        -a    : find (and show) all optimal v0-reduced divisors\n\
        -v    : verbose (show the optimal v0-reduced divisor)\n\
        -vv   : extra verbose (show the reduced divisor for every vertex in the graph)\n\
@@ -66,16 +123,38 @@ const int MAX_PARTS_PER_EDGE = 10; // edges may be subdivided into at most 10 pa
 #include "graph6.h"
 #include "graph_io.h"
 #include "divisors.h"
+#include "parallel_rank.h"
+#include "pipeline.h"
+#include "certificates.h"
+#include "search_ranges.h"
+#include "scramble.h"
+#include "resumable_search.h"
+#include "autotune.h"
+#include "batched_kernels.h"
+#include "hybrid_scheduler.h"
+#include "compressed_input.h"
+#include "alloc_stats.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cstring>
 #include <cstdio>
 #include <cctype>
+#include <climits>
+#include <chrono>
 
 using namespace std;
 
 bool arg_a = false;
+bool arg_c = false;
+bool arg_b = false;
+bool arg_i = false;
+bool arg_t = false;
+bool arg_s = false;
+int arg_j = 0;
+int arg_d = 0;
+int arg_r_part = 0;
+int arg_r_parts = 1;
 int verbosity = 0;
 int arg_k = 1;
 
@@ -107,16 +186,181 @@ void show_divisor() {
 	found_something = true;
 }
 
+// Output for a graph whose gonality was computed by the interleaved scheduler (option -i).
+void show_interleaved_result(const my_graph& G, const gonality_search& S) {
+	{
+		ALLOC_PHASE("graph copy");
+		H = G;
+	}
+	for (int i = 0; i < H.n; i++) {
+		__partial_divisor[i] = S.divisor[i];
+	}
+	if (arg_c) {
+		cout << "# " << G.graph_name << ": " << S.degree << '\n';
+		print_certificate(cout, H, __partial_divisor, S.failed_search_leaves);
+	}
+	else {
+		cout << G.graph_name << ": " << S.degree << endl;
+		show_divisor();
+	}
+}
+
+interleaved_scheduler scheduler(show_interleaved_result);
+
+void finish_interleaved() {
+	scheduler.finish();
+}
+
+// Output for a graph whose gonality was computed by the batch scheduler (option -b)
+// or the hybrid scheduler (option -j).
+void show_batched_result(const my_graph& G, const int gonality, const int* divisor) {
+	{
+		ALLOC_PHASE("graph copy");
+		H = G;
+	}
+	for (int i = 0; i < H.n; i++) {
+		__partial_divisor[i] = divisor[i];
+	}
+	cout << G.graph_name << ": " << gonality << endl;
+	show_divisor();
+}
+
+batch_scheduler batches(show_batched_result);
+
+void finish_batched() {
+	batches.finish();
+}
+
+hybrid_scheduler hybrid(show_batched_result);
+
+// Store the graph to be solved (G or its subdivision) in H.
+void prepare_H(const my_graph& G) {
+	ALLOC_PHASE("graph copy");
+	H = (arg_k == 1 ? G : subdivide(G, arg_k));
+}
+
+const unsigned long long RANGE_CHUNK = 65536; // number of candidates between two checks of the clock (option -r)
+
+// Search range arg_r_part of arg_r_parts of the search at degree arg_d in H (options -d and -r). The range is
+// searched in chunks of RANGE_CHUNK candidates, and the number of candidates searched so far is shown on standard
+// error at most once per second.
+void search_range(const string& name) {
+	const unsigned long long total = count_search_leaves(H.n, arg_d);
+	if (total == ULLONG_MAX) {
+		cerr << "Error: the search at degree " << arg_d << " on " << H.n << " vertices is too large to divide into ranges." << endl;
+		exit(1);
+	}
+	unsigned long long first, last;
+	search_range_part(H.n, arg_d, arg_r_parts, arg_r_part, first, last);
+	bool found = false;
+	std::chrono::steady_clock::time_point last_report = std::chrono::steady_clock::now();
+	for (unsigned long long i = first; i < last && !found; ) {
+		const unsigned long long j = (last - i > RANGE_CHUNK ? i + RANGE_CHUNK : last);
+		found = find_positive_rank_divisor_in_range(H, arg_d, i, j);
+		i += __search_leaves;
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (!found && i < last && now - last_report >= std::chrono::seconds(1)) {
+			cerr << name << ": searched " << i - first << "/" << last - first << " candidates" << endl;
+			last_report = now;
+		}
+	}
+	cout << name << ": degree " << arg_d << ", part " << arg_r_part << "/" << arg_r_parts;
+	cout << " (candidates [" << first << ", " << last << ") of " << total << "): ";
+	cout << (found ? "positive rank divisor found" : "no positive rank divisor") << endl;
+	if (found) {
+		show_divisor();
+	}
+}
+
 void solve(const my_graph& G) {
+	ALLOC_GRAPH(G.graph_name);
 	assert(arg_k >= 1 && arg_k <= MAX_PARTS_PER_EDGE);
 	assert(G.is_valid_undirected_graph());
+	if (arg_i) {
+		if (arg_k == 1) {
+			scheduler.add(G);
+		}
+		else {
+			my_graph S = subdivide(G, arg_k);
+			S.graph_name = G.graph_name;
+			scheduler.add(S);
+		}
+		return;
+	}
+	if (arg_b) {
+		if (arg_k == 1) {
+			batches.add(G);
+		}
+		else {
+			my_graph S = subdivide(G, arg_k);
+			S.graph_name = G.graph_name;
+			batches.add(S);
+		}
+		return;
+	}
+	if (arg_j) {
+		if (arg_k == 1) {
+			hybrid.add(G);
+		}
+		else {
+			my_graph S = subdivide(G, arg_k);
+			S.graph_name = G.graph_name;
+			hybrid.add(S);
+		}
+		return;
+	}
+	if (arg_d) {
+		prepare_H(G);
+		search_range(G.graph_name);
+		return;
+	}
+	if (arg_c) {
+		prepare_H(G);
+		scramble S;
+		S.order = 1;
+		int gon;
+		if (arg_s) {
+			// If a scramble of order gon exists, it is the lower bound, and the search at degree gon - 1 is not needed.
+			// Otherwise, only that search is repeated, to count its leaves; the divisor from find_gonality() is kept.
+			gon = find_gonality(H);
+			S = find_scramble(H, gon);
+			__failed_search_leaves = 0;
+			if (S.order < gon) {
+				vector<int> D(__partial_divisor, __partial_divisor + H.n);
+				bool found = find_positive_rank_divisor(H, gon - 1);
+				assert(!found);
+				(void) found;
+				__failed_search_leaves = __search_leaves;
+				for (int i = 0; i < H.n; i++) {
+					__partial_divisor[i] = D[i];
+				}
+			}
+		}
+		else {
+			gon = find_gonality_by_degree(H); // the certificate summarises the search at degree gon - 1
+		}
+		cout << "# " << G.graph_name << ": " << gon << '\n';
+		if (arg_s && verbosity >= 1) {
+			cout << "# Scramble lower bound: " << S.order << " (" << S.eggs.size() << " eggs)" << '\n';
+		}
+		print_certificate(cout, H, __partial_divisor, __failed_search_leaves, (gon == S.order ? &S : NULL));
+		return;
+	}
 	cout << G.graph_name << ":";
 	cout.flush();
-	H = (arg_k == 1 ? G : subdivide(G, arg_k));
+	prepare_H(G);
+	scramble S;
+	S.order = 1;
+	if (arg_s) {
+		S = find_scramble(H, gonality_upper_bound(H));
+	}
 	if (arg_a) {
 		found_something = false;
 		cout << endl;
-		for (int deg = 1; deg <= H.n; deg++) {
+		if (arg_s && verbosity >= 1) {
+			cout << "  Scramble lower bound: " << S.order << " (" << S.eggs.size() << " eggs)" << endl;
+		}
+		for (int deg = S.order; deg <= H.n; deg++) {
 			find_all_positive_rank_v0_reduced_divisors(H, deg, show_divisor);
 			if (found_something) {
 				break;
@@ -124,8 +368,17 @@ void solve(const my_graph& G) {
 		}
 		assert(found_something);
 	}
+	else if (arg_t) {
+		autotune_report report;
+		cout << ' ' << autotuned_gonality(H, report) << endl;
+		print_autotune_report(cout, report, verbosity >= 1);
+		show_divisor();
+	}
 	else {
-		cout << ' ' << find_gonality(H) << endl;
+		cout << ' ' << find_gonality(H, MAX_N, S.order) << endl;
+		if (arg_s && verbosity >= 1) {
+			cout << "  Scramble lower bound: " << S.order << " (" << S.eggs.size() << " eggs)" << endl;
+		}
 		show_divisor();
 	}
 }
@@ -141,12 +394,19 @@ int main(int argc, char* argv[]) {
 	// Parse command-line arguments
 	bool badargs = false;
 	bool arg_g = false;
+	bool arg_p = false;
 	bool arg_h = false;
+	bool arg_r = false;
+	int arg_R = -1;
 	char tmp[30];
 	for (int i = 1; i < argc && !badargs; i++) {
 		unsigned l = strlen(argv[i]);
 		assert(l >= 1);
 		if (argv[i][0] == '-') {
+			bool need_threads = false;
+			bool need_rank_threads = false;
+			bool need_degree = false;
+			bool need_range = false;
 			for (unsigned j = 1; j < l; j++) {
 				switch (argv[i][j]) {
 					case 'h':
@@ -155,9 +415,39 @@ int main(int argc, char* argv[]) {
 					case 'g':
 						arg_g = true;
 						break;
+					case 'p':
+						arg_p = true;
+						break;
 					case 'a':
 						arg_a = true;
 						break;
+					case 'c':
+						arg_c = true;
+						break;
+					case 'b':
+						arg_b = true;
+						break;
+					case 'i':
+						arg_i = true;
+						break;
+					case 't':
+						arg_t = true;
+						break;
+					case 's':
+						arg_s = true;
+						break;
+					case 'j':
+						need_threads = true;
+						break;
+					case 'R':
+						need_rank_threads = true;
+						break;
+					case 'd':
+						need_degree = true;
+						break;
+					case 'r':
+						need_range = true;
+						break;
 					case 'v':
 						verbosity++;
 						break;
@@ -166,6 +456,35 @@ int main(int argc, char* argv[]) {
 						break;
 				}
 			}
+			if (need_threads) {
+				i++;
+				if (i >= argc || sscanf(argv[i], "%d", &arg_j) != 1 || arg_j < 1) {
+					cerr << "Error: option -j should be followed by the number of threads." << endl;
+					badargs = true;
+				}
+			}
+			if (need_rank_threads) {
+				i++;
+				if (i >= argc || sscanf(argv[i], "%d", &arg_R) != 1 || arg_R < 1) {
+					cerr << "Error: option -R should be followed by the number of threads." << endl;
+					badargs = true;
+				}
+			}
+			if (need_degree) {
+				i++;
+				if (i >= argc || sscanf(argv[i], "%d", &arg_d) != 1 || arg_d < 1) {
+					cerr << "Error: option -d should be followed by a positive degree." << endl;
+					badargs = true;
+				}
+			}
+			if (need_range) {
+				arg_r = true;
+				i++;
+				if (i >= argc || sscanf(argv[i], "%d/%d", &arg_r_part, &arg_r_parts) != 2 || arg_r_parts < 1 || arg_r_part < 0 || arg_r_part >= arg_r_parts) {
+					cerr << "Error: option -r should be followed by I/N, with 0 <= I < N." << endl;
+					badargs = true;
+				}
+			}
 		}
 		else if (isdigit(argv[i][0])) {
 			int k;
@@ -191,24 +510,82 @@ int main(int argc, char* argv[]) {
 			badargs = true;
 		}
 	}
+	if (arg_i && arg_a) {
+		cerr << "Error: options -i and -a cannot be combined." << endl;
+		badargs = true;
+	}
+	if (arg_t && (arg_a || arg_c || arg_i)) {
+		cerr << "Error: option -t cannot be combined with -a, -c or -i." << endl;
+		badargs = true;
+	}
+	if (arg_b && (arg_a || arg_c || arg_i || arg_t)) {
+		cerr << "Error: option -b cannot be combined with -a, -c, -i or -t." << endl;
+		badargs = true;
+	}
+	if (arg_j && (arg_a || arg_c || arg_i || arg_t || arg_b || arg_p)) {
+		cerr << "Error: option -j cannot be combined with -a, -c, -i, -t, -b or -p." << endl;
+		badargs = true;
+	}
+	if (arg_j && arg_R != -1) {
+		cerr << "Error: options -j and -R cannot be combined." << endl;
+		badargs = true;
+	}
+	if (arg_s && (arg_i || arg_t || arg_b || arg_j)) {
+		cerr << "Error: option -s cannot be combined with -i, -t, -b or -j." << endl;
+		badargs = true;
+	}
+	if (arg_d && (arg_a || arg_c || arg_i || arg_t || arg_b || arg_j || arg_s)) {
+		cerr << "Error: option -d cannot be combined with -a, -c, -i, -t, -b, -j or -s." << endl;
+		badargs = true;
+	}
+	if (arg_r && !arg_d) {
+		cerr << "Error: option -r can only be used together with -d." << endl;
+		badargs = true;
+	}
 	if (arg_h || badargs) {
 		cerr << (badargs ? "Invalid argument(s)." : "Requested help.") << endl;
 		usage();
 		exit(badargs ? 1 : 0);
 	}
 	
+	if (arg_j) {
+		parallel_rank_configure(1, PARALLEL_RANK_MIN_N); // the threads are used for the graphs instead
+		hybrid.start(arg_j);
+	}
+	else if (arg_R != -1) {
+		parallel_rank_configure(arg_R, PARALLEL_RANK_MIN_N);
+	}
+	if (arg_i || arg_b || arg_j) {
+		alloc_stats_disable_graphs(); // the graphs are solved later, or on other threads
+	}
+	
 	// Read and process input
-	if (arg_g) {
+	compressed_istream input(cin);
+	if (arg_p) {
+		read_and_process_pipelined(input, arg_g, solve, (arg_i ? finish_interleaved : (arg_b ? finish_batched : NULL)));
+	}
+	else if (arg_g) {
 		string s;
-		while (getline(cin, s)) {
+		while (getline(input, s)) {
 			my_graph G = parse_graph6(s);
 			G.graph_name = s;
 			solve(G);
 		}
 	}
 	else {
-		read_plain_input_and_process(cin, solve);
+		read_plain_input_and_process(input, solve);
+	}
+	if (arg_i && !arg_p) {
+		finish_interleaved();
+	}
+	if (arg_b && !arg_p) {
+		finish_batched();
+	}
+	if (arg_j) {
+		hybrid.finish();
+		hybrid.print_statistics(cerr);
 	}
+	alloc_stats_report();
 	return 0;
 }
 
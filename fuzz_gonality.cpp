@@ -0,0 +1,708 @@
+// Differential fuzzing harness for the gonality engines.
+//
+// This program generates random graphs (simple graphs, multigraphs, and subdivisions), and compares the
+// output of every optimised engine and mode against the reference brute force search from divisors.h.
+// For every graph, the following is checked:
+//     * every engine computes the same gonality as the reference search;
+//     * every divisor returned by an engine is effective, has the right degree, and has positive rank
+//       (according to the reference implementation of has_positive_rank());
+//     * engines that promise to visit the candidates in the same order as the reference search return
+//       exactly the same divisor;
+//     * every implementation of the positive rank test agrees with the reference implementation on a
+//       number of random effective divisors, and multi-source burning agrees with burn() from every
+//       vertex on these divisors;
+//     * the scrambles found by find_scramble() are valid, and their order (as reported, and as recomputed
+//       by scramble_order()) is at most the gonality;
+//     * the treewidth bounds from treewidth.h satisfy lower bound <= treewidth <= upper bound (with the exact
+//       treewidth for small graphs), the treewidth is at most the gonality, and treewidth_at_least() agrees
+//       with the exact treewidth.
+//
+// As soon as a disagreement is found, the graph is minimised (by greedily deleting edges and vertices
+// for as long as some disagreement remains), and the minimised graph is printed in the plain input
+// format (and in graph6 format, if it is simple), so that it can be fed to the other programs.
+//
+// Usage:
+//       ./fuzz_gonality [-v] [iterations [seed]]
+//
+//       Numerical arguments:
+//       iterations : number of random graphs to test (default: 1000)
+//       seed       : seed for the random number generator (default: based on the current time)
+//
+//       Output options:
+//       -v  : verbose (print every graph that is tested)
+//
+// The program exits with status 1 if a disagreement was found.
+//
+// To add a new engine, write a wrapper function for it and add it to one of the lists gonality_engines
+// and rank_engines below.
+
+
+#define USAGE_STRING \
+"fuzz_gonality [-v] [iterations [seed]]"
+
+#define HELPTEXT \
+" Compare all gonality engines against the reference brute force search on random graphs.\n\
+\n\
+\n\
+    Numerical arguments:\n\
+        iterations : number of random graphs to test (default: 1000)\n\
+        seed       : seed for the random number generator (default: current time)\n\
+\n\
+    Output options:\n\
+       -v    : verbose (print every graph that is tested)\n\
+\n\
+  See program text for much more information.\n"
+
+
+// Graph limits (should be defined BEFORE loading graphs.h or divisors.h).
+# ifndef __GRAPH_LIMITS__
+# define __GRAPH_LIMITS__
+const int MAX_N = 100;
+const int MAX_M = 1000;
+const int MAX_PARTS_PER_EDGE = 4;
+# endif
+
+#include "graphs.h"
+#include "subdivisions.h"
+#include "graph6.h"
+#include "graph_io.h"
+#include "divisors.h"
+#include "parallel_rank.h"
+#include "resumable_search.h"
+#include "autotune.h"
+#include "batched_kernels.h"
+#include "search_ranges.h"
+#include "hybrid_scheduler.h"
+#include "scramble.h"
+#include "treewidth.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cassert>
+
+using namespace std;
+
+const int FUZZ_MAX_BASE_N = 9;        // maximum number of vertices of the generated graphs (before subdividing)
+const int FUZZ_MAX_SUBDIVIDED_N = 30; // skip subdivisions with more vertices than this (too slow)
+const int FUZZ_RANK_TESTS = 20;       // number of random divisors per graph for the positive rank tests
+const int FUZZ_NUM_THREADS = 4;       // number of threads for the parallel positive rank test
+const int FUZZ_SCRAMBLE_RUNS = 4;         // number of runs of the scramble searches
+
+int verbosity = 0;
+mt19937 rng;
+
+// Divisor returned by the current engine.
+vector<int> engine_divisor;
+
+// Description of an internal inconsistency noticed by the current engine, or empty if there is none. These are
+// reported as disagreements, like wrong results (rather than asserted, so that they are also caught in release builds).
+string engine_error;
+
+
+
+// ENGINES
+//
+// Every gonality engine computes the gonality of G, stores a positive rank divisor of minimal degree in
+// engine_divisor, and returns the gonality. Every rank engine returns whether the given divisor has
+// positive rank.
+
+void use_reference_engines() {
+	__parallel_rank_min_n = MAX_N + 1;
+}
+
+int gonality_reference(const my_graph& G) {
+	use_reference_engines();
+	int gon = find_gonality_by_degree(G);
+	engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+	return gon;
+}
+
+int gonality_parallel_rank(const my_graph& G) {
+	__parallel_rank_min_n = 1;
+	int gon = find_gonality_by_degree(G);
+	engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+	use_reference_engines();
+	return gon;
+}
+
+int gonality_one_pass(const my_graph& G) {
+	use_reference_engines();
+	int gon = find_gonality(G);
+	engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+	return gon;
+}
+
+int gonality_one_pass_parallel_rank(const my_graph& G) {
+	use_reference_engines();
+	__parallel_rank_min_n = 1;
+	int gon = find_gonality(G);
+	engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+	use_reference_engines();
+	return gon;
+}
+
+// Autotuned engine (the probes and the cache are shared by all graphs of the run).
+int gonality_autotuned(const my_graph& G) {
+	use_reference_engines();
+	autotune_report report;
+	int gon = autotuned_gonality(G, report);
+	engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+	return gon;
+}
+
+// Batched search, with G in a random lane and random connected simple graphs on the same vertices in the other lanes
+// (so that interference between the lanes is noticed). Graphs that cannot be batched use find_gonality().
+int gonality_batched(const my_graph& G) {
+	use_reference_engines();
+	if (!is_batchable(G)) {
+		return gonality_one_pass(G);
+	}
+	graph_batch B;
+	B.init(G.n);
+	const int lane = rng() % BATCH_LANES;
+	for (int l = 0; l < BATCH_LANES; l++) {
+		if (l == lane) {
+			B.add(G);
+			continue;
+		}
+		my_graph F(G.n);
+		for (int b = 1; b < G.n; b++) {
+			const int a = rng() % b;
+			F.add_edge(a, b);
+			for (int c = 0; c < b; c++) {
+				if (c != a && rng() % 2) {
+					F.add_edge(c, b);
+				}
+			}
+		}
+		B.add(F);
+	}
+	solve_batch(B);
+	engine_divisor.assign(B.divisor[lane], B.divisor[lane] + G.n);
+	return B.gonality[lane];
+}
+
+// Hybrid scheduler on a few threads, with a very small split threshold (so that most graphs are split into
+// subtree tasks). The threads are started at the first call.
+const int FUZZ_HYBRID_THREADS = 3;
+const long long FUZZ_HYBRID_SPLIT_LEAVES = 4;
+
+int hybrid_gonality;
+
+void hybrid_done(const my_graph& G, const int gonality, const int* divisor) {
+	hybrid_gonality = gonality;
+	engine_divisor.assign(divisor, divisor + G.n);
+}
+
+hybrid_scheduler hybrid(hybrid_done);
+
+int gonality_hybrid(const my_graph& G) {
+	static bool started = false;
+	use_reference_engines();
+	if (!started) {
+		hybrid.start(FUZZ_HYBRID_THREADS, FUZZ_HYBRID_SPLIT_LEAVES);
+		started = true;
+	}
+	hybrid.add(G);
+	hybrid.flush();
+	return hybrid_gonality;
+}
+
+// Brute force search at every degree, divided into a random number of consecutive index ranges (see
+// search_ranges.h) that are searched in turn. Ranking is checked against unranking at every range boundary.
+int gonality_ranges(const my_graph& G) {
+	use_reference_engines();
+	vector<int> D(G.n);
+	for (int deg = 1; ; deg++) {
+		const unsigned long long total = count_search_leaves(G.n, deg);
+		vector<unsigned long long> bounds = {0, total};
+		for (int k = rng() % 4; k > 0; k--) {
+			bounds.push_back(rng() % (total + 1));
+		}
+		sort(bounds.begin(), bounds.end());
+		for (size_t k = 0; k + 1 < bounds.size(); k++) {
+			if (bounds[k] < total) {
+				search_unrank(G.n, deg, bounds[k], D.data());
+				if (search_rank(G.n, D.data()) != bounds[k]) {
+					engine_error = "search_rank() does not invert search_unrank() at index " + to_string(bounds[k]) + " of degree " + to_string(deg);
+					return -1;
+				}
+			}
+			if (find_positive_rank_divisor_in_range(G, deg, bounds[k], bounds[k + 1])) {
+				engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+				return deg;
+			}
+		}
+	}
+}
+
+// Resumable one-pass search, suspended after a random number of leaves, and serialized and read back every
+// time. This must find the same divisor as find_gonality(), after the same number of leaves.
+int gonality_resumable(const my_graph& G) {
+	use_reference_engines();
+	gonality_search S;
+	S.init(G);
+	while (!S.step(G, 1 + rng() % 50)) {
+		gonality_search copy;
+		if (!copy.deserialize(S.serialize())) {
+			engine_error = "cannot read back its serialized state \"" + S.serialize() + "\"";
+			return -1;
+		}
+		S = copy;
+	}
+	const int gon = find_gonality(G);
+	if (S.divisor != vector<int>(__partial_divisor, __partial_divisor + G.n) || S.leaves != __search_leaves) {
+		engine_error = "finds a different divisor than find_gonality(), or uses a different number of leaves";
+		return -1;
+	}
+	if (gon == 1 ? S.failed_search_leaves != 0 : (find_positive_rank_divisor(G, gon - 1) || S.failed_search_leaves != __search_leaves)) {
+		engine_error = "reports the wrong number of leaves for the search at degree gonality - 1";
+		return -1;
+	}
+	engine_divisor = S.divisor;
+	return S.degree;
+}
+
+// Degree loop around the resumable brute force search, suspended after a random number of leaves, and
+// serialized and read back every time.
+int gonality_resumable_by_degree(const my_graph& G) {
+	use_reference_engines();
+	for (int deg = 1; ; deg++) {
+		positive_rank_search S;
+		S.init(G.n, deg);
+		while (S.step(G, 1 + rng() % 50) == SEARCH_RUNNING) {
+			positive_rank_search copy;
+			if (!copy.deserialize(S.serialize())) {
+				engine_error = "cannot read back its serialized state \"" + S.serialize() + "\"";
+				return -1;
+			}
+			S = copy;
+		}
+		if (S.status == SEARCH_FOUND) {
+			engine_divisor = S.divisor;
+			return deg;
+		}
+	}
+}
+
+// Degree loop and one-pass search, starting at the order of a scramble.
+int gonality_scramble_by_degree(const my_graph& G) {
+	use_reference_engines();
+	int gon = find_gonality_by_degree(G, MAX_N, find_scramble(G, gonality_upper_bound(G), FUZZ_SCRAMBLE_RUNS).order);
+	engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+	return gon;
+}
+
+int gonality_scramble_one_pass(const my_graph& G) {
+	use_reference_engines();
+	int gon = find_gonality(G, MAX_N, find_scramble(G, gonality_upper_bound(G), FUZZ_SCRAMBLE_RUNS).order);
+	engine_divisor.assign(__partial_divisor, __partial_divisor + G.n);
+	return gon;
+}
+
+bool rank_reference(const my_graph& G, const int* D) {
+	use_reference_engines();
+	return has_positive_rank(G, D, false);
+}
+
+bool rank_parallel(const my_graph& G, const int* D) {
+	int ret = parallel_has_positive_rank(G, D);
+	if (ret == -1) {
+		engine_error = "is not available (returns -1)";
+	}
+	return ret == 1;
+}
+
+// Compare multi_burn() with burn() from every vertex, both the lanes that are reduced and the burnt
+// vertices in every lane. The start vertices are taken in blocks of consecutive vertices, and the last
+// vertex of every block is repeated in an extra lane (so that repeated start vertices are tested too).
+// Returns a start vertex where they disagree, or -1.
+int check_multi_burn(const my_graph& G, const int* D) {
+	int starts[MULTI_BURN_LANES];
+	for (int first = 0; first < G.n; first += MULTI_BURN_LANES - 1) {
+		int num_starts = 0;
+		while (num_starts < MULTI_BURN_LANES - 1 && first + num_starts < G.n) {
+			starts[num_starts] = first + num_starts;
+			num_starts++;
+		}
+		starts[num_starts] = starts[num_starts - 1];
+		num_starts++;
+		const uint64_t reduced = multi_burn(G, D, starts, num_starts);
+		vector<uint64_t> burnt(__multi_burnt, __multi_burnt + G.n);
+		for (int s = 0; s < num_starts; s++) {
+			if ((burn(G, D, starts[s]) == 0) != (((reduced >> s) & 1) != 0)) {
+				return starts[s];
+			}
+			for (int i = 0; i < G.n; i++) {
+				if (__pushed_to_queue[i] != (((burnt[i] >> s) & 1) != 0)) {
+					return starts[s];
+				}
+			}
+		}
+	}
+	return -1;
+}
+
+struct gonality_engine {
+	const char* name;
+	int (*fn)(const my_graph&);
+	bool same_order; // visits the candidates in the same order as the reference search
+};
+
+struct rank_engine {
+	const char* name;
+	bool (*fn)(const my_graph&, const int*);
+};
+
+const gonality_engine gonality_engines[] = {
+	{"parallel positive rank test", gonality_parallel_rank, true},
+	{"resumable search", gonality_resumable, false},
+	{"resumable brute force search (degree loop)", gonality_resumable_by_degree, true},
+	{"one-pass search", gonality_one_pass, false},
+	{"one-pass search with parallel positive rank test", gonality_one_pass_parallel_rank, false},
+	{"autotuned", gonality_autotuned, false},
+	{"batched kernels", gonality_batched, false},
+	{"hybrid scheduler", gonality_hybrid, false},
+	{"range search", gonality_ranges, true},
+	{"scramble lower bound (degree loop)", gonality_scramble_by_degree, true},
+	{"scramble lower bound (one-pass search)", gonality_scramble_one_pass, false},
+};
+
+const rank_engine rank_engines[] = {
+	{"parallel positive rank test", rank_parallel},
+};
+
+
+
+// Run all engines on G. Returns an empty string if all engines agree, and a description of the
+// first disagreement otherwise. The random divisors for the rank tests only depend on the graph,
+// so that the outcome is reproducible (which is needed for the minimisation).
+string check_graph(const my_graph& G) {
+	ostringstream problem;
+	const int gon = gonality_reference(G);
+	const vector<int> reference_divisor = engine_divisor;
+	for (const gonality_engine& e : gonality_engines) {
+		engine_error.clear();
+		const int g = e.fn(G);
+		if (!engine_error.empty()) {
+			problem << e.name << ": " << engine_error;
+			return problem.str();
+		}
+		if (g != gon) {
+			problem << e.name << " computes gonality " << g << " instead of " << gon;
+			return problem.str();
+		}
+		int deg = 0;
+		bool effective = ((int) engine_divisor.size() == G.n);
+		for (int i = 0; effective && i < G.n; i++) {
+			effective = (engine_divisor[i] >= 0);
+			deg += engine_divisor[i];
+		}
+		if (!effective || deg != gon || !rank_reference(G, engine_divisor.data())) {
+			problem << e.name << " returns an invalid divisor";
+			return problem.str();
+		}
+		if (e.same_order && engine_divisor != reference_divisor) {
+			problem << e.name << " returns a different divisor than the reference search";
+			return problem.str();
+		}
+	}
+	const scramble S = find_scramble(G, gonality_upper_bound(G), FUZZ_SCRAMBLE_RUNS);
+	const int order = scramble_order(G, S.eggs);
+	if (order != S.order || order > gon) {
+		problem << "scramble search reports order " << S.order << " (recomputed: " << order << ") for gonality " << gon;
+		return problem.str();
+	}
+	// The treewidth is a lower bound for the gonality (see treewidth.h); subdivision_conjecture relies on this.
+	const int tw_lower = treewidth_lower_bound(G);
+	const int tw_upper = treewidth_upper_bound(G);
+	const int tw = (G.n <= TREEWIDTH_EXACT_MAX_N ? treewidth_exact(G) : tw_lower);
+	if (tw_lower > tw || tw > tw_upper || tw > gon) {
+		problem << "treewidth bounds " << tw_lower << " <= " << tw << (G.n <= TREEWIDTH_EXACT_MAX_N ? " (exact)" : "");
+		problem << " <= " << tw_upper << " do not hold, or exceed gonality " << gon;
+		return problem.str();
+	}
+	for (int k = 0; k <= gon + 1; k++) {
+		if (treewidth_at_least(G, k) && tw < k) {
+			problem << "treewidth_at_least() claims treewidth at least " << k << ", but the treewidth is " << tw;
+			return problem.str();
+		}
+		if (!treewidth_at_least(G, k) && G.n <= TREEWIDTH_EXACT_MAX_N && tw >= k) {
+			problem << "treewidth_at_least() cannot decide treewidth at least " << k << ", although the treewidth is " << tw;
+			return problem.str();
+		}
+	}
+	seed_seq seq(reference_divisor.begin(), reference_divisor.end());
+	mt19937 local_rng(seq);
+	vector<int> D(G.n);
+	for (int t = 0; t < FUZZ_RANK_TESTS; t++) {
+		const int deg = 1 + local_rng() % (gon + 1);
+		fill(D.begin(), D.end(), 0);
+		for (int j = 0; j < deg; j++) {
+			D[local_rng() % G.n]++;
+		}
+		const bool expected = rank_reference(G, D.data());
+		for (const rank_engine& e : rank_engines) {
+			engine_error.clear();
+			const bool r = e.fn(G, D.data());
+			if (!engine_error.empty()) {
+				problem << e.name << ": " << engine_error;
+				return problem.str();
+			}
+			if (r != expected) {
+				problem << e.name << " disagrees with the reference on divisor [";
+				for (int i = 0; i < G.n; i++) {
+					problem << (i ? ", " : "") << D[i];
+				}
+				problem << "] (expected: " << (expected ? "positive rank" : "rank 0") << ")";
+				return problem.str();
+			}
+		}
+		const int v = check_multi_burn(G, D.data());
+		if (v != -1) {
+			problem << "multi-source burning disagrees with burn() from vertex " << v << " on divisor [";
+			for (int i = 0; i < G.n; i++) {
+				problem << (i ? ", " : "") << D[i];
+			}
+			problem << "]";
+			return problem.str();
+		}
+	}
+	return "";
+}
+
+
+
+// RANDOM GRAPHS
+
+bool is_connected(const my_graph& G) {
+	if (G.n == 0) {
+		return false;
+	}
+	vector<bool> seen(G.n, false);
+	vector<int> stack(1, 0);
+	seen[0] = true;
+	int count = 1;
+	while (!stack.empty()) {
+		int v = stack.back();
+		stack.pop_back();
+		for (int w : G.neighbours[v]) {
+			if (!seen[w]) {
+				seen[w] = true;
+				count++;
+				stack.push_back(w);
+			}
+		}
+	}
+	return count == G.n;
+}
+
+// Random connected graph: a random spanning tree plus random extra edges (possibly parallel ones).
+my_graph random_graph(bool allow_parallel_edges) {
+	const int n = 2 + rng() % (FUZZ_MAX_BASE_N - 1);
+	my_graph G(n);
+	for (int v = 1; v < n; v++) {
+		G.add_edge(v, rng() % v);
+	}
+	const int extra = rng() % (n * (n - 1) / 2 + 1);
+	for (int t = 0; t < extra; t++) {
+		int a = rng() % n, b = rng() % n;
+		if (a == b) {
+			continue;
+		}
+		bool present = false;
+		for (int w : G.neighbours[a]) {
+			present |= (w == b);
+		}
+		if (!present || (allow_parallel_edges && rng() % 3 == 0)) {
+			G.add_edge(a, b);
+		}
+	}
+	return G;
+}
+
+my_graph random_test_graph(string& kind) {
+	while (true) {
+		switch (rng() % 3) {
+			case 0:
+				kind = "simple graph";
+				return random_graph(false);
+			case 1:
+				kind = "multigraph";
+				return random_graph(true);
+			default: {
+				my_graph G = random_graph(rng() % 2 == 0);
+				const int k = 2 + rng() % (MAX_PARTS_PER_EDGE - 1);
+				if (G.n + G.count_edges() * (k - 1) > FUZZ_MAX_SUBDIVIDED_N) {
+					continue;
+				}
+				kind = to_string(k) + "-subdivision";
+				return subdivide(G, k);
+			}
+		}
+	}
+}
+
+
+
+// MINIMISATION
+
+my_graph without_edge(const my_graph& G, int a, int b) {
+	my_graph H(G.n);
+	bool removed = false;
+	for (int i = 0; i < G.n; i++) {
+		for (int j : G.neighbours[i]) {
+			if (i < j) {
+				if (!removed && i == a && j == b) {
+					removed = true;
+				}
+				else {
+					H.add_edge(i, j);
+				}
+			}
+		}
+	}
+	return H;
+}
+
+my_graph without_vertex(const my_graph& G, int v) {
+	my_graph H(G.n - 1);
+	for (int i = 0; i < G.n; i++) {
+		for (int j : G.neighbours[i]) {
+			if (i < j && i != v && j != v) {
+				H.add_edge(i - (i > v), j - (j > v));
+			}
+		}
+	}
+	return H;
+}
+
+// Greedily delete vertices and edges while the graph remains connected and some engine still disagrees.
+my_graph minimise(my_graph G) {
+	bool progress = true;
+	while (progress) {
+		progress = false;
+		for (int v = 0; v < G.n && G.n > 1 && !progress; v++) {
+			my_graph H = without_vertex(G, v);
+			if (is_connected(H) && !check_graph(H).empty()) {
+				G = H;
+				progress = true;
+			}
+		}
+		for (int i = 0; i < G.n && !progress; i++) {
+			for (int j : G.neighbours[i]) {
+				if (i < j) {
+					my_graph H = without_edge(G, i, j);
+					if (is_connected(H) && !check_graph(H).empty()) {
+						G = H;
+						progress = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+	return G;
+}
+
+
+
+void usage() {
+	cerr << endl;
+	cerr << "Usage: " << USAGE_STRING << endl;
+	cerr << endl;
+	cerr << HELPTEXT << endl;
+}
+
+int main(int argc, char* argv[]) {
+	// Parse command-line arguments
+	bool badargs = false;
+	bool arg_h = false;
+	long long iterations = 1000;
+	unsigned long seed = time(NULL);
+	int num_numerical_args = 0;
+	char tmp[30];
+	for (int i = 1; i < argc && !badargs; i++) {
+		unsigned l = strlen(argv[i]);
+		assert(l >= 1);
+		if (argv[i][0] == '-') {
+			for (unsigned j = 1; j < l; j++) {
+				switch (argv[i][j]) {
+					case 'h':
+						arg_h = true;
+						break;
+					case 'v':
+						verbosity++;
+						break;
+					default:
+						badargs = true;
+						break;
+				}
+			}
+		}
+		else if (isdigit(argv[i][0]) && num_numerical_args < 2) {
+			unsigned long x;
+			if (sscanf(argv[i], "%lu", &x) != 1) {
+				badargs = true;
+				break;
+			}
+			sprintf(tmp, "%lu", x);
+			if (strcmp(argv[i], tmp)) {
+				badargs = true;
+				break;
+			}
+			if (num_numerical_args++ == 0) {
+				iterations = x;
+			}
+			else {
+				seed = x;
+			}
+		}
+		else {
+			badargs = true;
+		}
+	}
+	if (arg_h || badargs) {
+		cerr << (badargs ? "Invalid argument(s)." : "Requested help.") << endl;
+		usage();
+		exit(badargs ? 1 : 0);
+	}
+
+	// Run tests
+	cout << "Testing " << iterations << " random graphs (seed: " << seed << ")." << endl;
+	rng.seed(seed);
+	parallel_rank_configure(FUZZ_NUM_THREADS, 1);
+	use_reference_engines();
+	for (long long t = 1; t <= iterations; t++) {
+		string kind;
+		my_graph G = random_test_graph(kind);
+		assert(is_connected(G));
+		if (verbosity >= 1) {
+			cout << "Graph " << t << ": " << kind << " on " << G.n << " vertices and " << G.count_edges() << " edges." << endl;
+		}
+		string problem = check_graph(G);
+		if (!problem.empty()) {
+			cout << "Graph " << t << " (" << kind << "): " << problem << "." << endl;
+			cout << "Minimising..." << endl;
+			my_graph H = minimise(G);
+			cout << "Minimal example: " << check_graph(H) << "." << endl;
+			cout << endl;
+			H.graph_name = "Counterexample (seed " + to_string(seed) + ", graph " + to_string(t) + ")";
+			print_plain_output(cout, H);
+			if (H.is_valid_undirected_graph(true)) {
+				cout << endl << "graph6: " << write_graph6(H) << endl;
+			}
+			return 1;
+		}
+	}
+	cout << "Summary: all engines agree on " << iterations << " graphs." << endl;
+	return 0;
+}
@@ -8,6 +8,7 @@
 #define __GRAPH6_H__
 
 #include "graphs.h"
+#include "alloc_stats.h"
 #include <cassert>
 #include <string>
 #include <vector>
@@ -60,6 +61,7 @@ long long readN(const std::string& s, size_t& pos) {
 }
 
 void parse_graph6(const std::string& s, my_graph& ret) {
+	ALLOC_PHASE("graph6 decode");
 	size_t pos = 0;
 	for (size_t i = 0; i < s.size(); i++) {
 		assert(s[i] >= 63 && s[i] <= 126);
@@ -142,11 +144,15 @@ std::string writeN(long long n) {
 	}
 	size_t l = strlen(tmp);
 	assert(l == 1 || l == 4 || l == 8);
+	(void) l;
 	return std::string(tmp);
 }
 
 std::string write_graph6(const my_graph& G) {
-	assert(G.is_valid_undirected_graph()); // check validy AND populate __adj_matr[][]
+	ALLOC_PHASE("graph6 encode");
+	bool valid = G.is_valid_undirected_graph(); // check validy AND populate __adj_matr[][] (not inside assert(), which disappears with -DNDEBUG)
+	assert(valid);
+	(void) valid;
 	// only simple graphs can be stored in graph6 format:
 	for (int i = 0; i < G.n; i++) {
 		if (__adj_matr[i][i] != 0) {
@@ -18,52 +18,74 @@
 #define __GRAPH_IO_H__
 
 #include "graphs.h"
+#include "alloc_stats.h"
 #include <cassert>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cstdio>
+#include <cstdlib>
 
 
-std::vector<std::string> __all_lines;
 my_graph __G;
 
-void __parse_next_graph(size_t& pos, void (*process_function)(const my_graph&)) {
+// Malformed input is reported even if the program is compiled with -DNDEBUG.
+void __plain_input_error(const std::string& line, const char* problem) {
+	std::cerr << "ERROR: invalid plain input (" << problem << ") on line \"" << line << "\"." << std::endl;
+	exit(1);
+}
+
+// Read the next non-empty line. Returns false at the end of the input.
+bool __next_nonempty_line(std::istream& is, std::string& line) {
+	while (std::getline(is, line)) {
+		if (!line.empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Read the rest of the graph with the given name (which has just been read), and process it.
+void __parse_next_graph(std::istream& is, const std::string& name, void (*process_function)(const my_graph&)) {
 	int n, m;
-	assert(pos <= __all_lines.size() - 2); // at least 2 lines of input remaining
+	std::string header, line;
+	if (!__next_nonempty_line(is, header)) {
+		__plain_input_error(name, "unexpected end of input after graph name");
+	}
 	__G.init();
-	__G.graph_name = __all_lines[pos];
-	pos++;
-	assert(sscanf(__all_lines[pos].c_str(), "%d %d", &n, &m) == 2);
-	assert(n >= 1 && n <= MAX_N);
-	assert(m >= 0 && m <= MAX_M);
-	pos++;
+	__G.graph_name = name;
+	if (sscanf(header.c_str(), "%d %d", &n, &m) != 2) {
+		__plain_input_error(header, "expected number of vertices and edges");
+	}
+	if (n < 1 || n > MAX_N || m < 0 || m > MAX_M) {
+		__plain_input_error(header, "number of vertices or edges out of range");
+	}
 	__G.setN(n);
-	assert(pos <= __all_lines.size() - m); // at least m lines of input remaining
 	for (int i = 0; i < m; i++) {
+		ALLOC_PHASE("plain input");
 		int a, b;
-		assert(sscanf(__all_lines[pos].c_str(), "%d %d", &a, &b) == 2);
-		assert(a >= 0 && a < n);
-		assert(b >= 0 && b < n);
-		assert(a != b);
-		pos++;
+		if (!__next_nonempty_line(is, line)) {
+			__plain_input_error(header, "unexpected end of input in list of edges");
+		}
+		if (sscanf(line.c_str(), "%d %d", &a, &b) != 2) {
+			__plain_input_error(line, "expected an edge");
+		}
+		if (a < 0 || a >= n || b < 0 || b >= n || a == b) {
+			__plain_input_error(line, "invalid edge");
+		}
 		__G.add_edge(a, b);
 	}
 	process_function(__G);
 	__G.init();
 }
 
+// Read the graphs one at a time, and process every graph as soon as it has been read (so that reading
+// and solving can overlap in pipelined mode; see pipeline.h).
 void read_plain_input_and_process(std::istream& is, void (*process_function)(const my_graph&)) {
-	std::string tmp_str;
+	std::string name;
 	__G.init();
-	while (std::getline(is, tmp_str)) {
-		if (!tmp_str.empty()) {
-			__all_lines.push_back(tmp_str);
-		}
-	}
-	size_t pos = 0;
-	while (pos < __all_lines.size()) {
-		__parse_next_graph(pos, process_function);
+	while (__next_nonempty_line(is, name)) {
+		__parse_next_graph(is, name, process_function);
 	}
 }
 
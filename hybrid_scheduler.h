@@ -0,0 +1,394 @@
+// Multithreaded gonality computation for many graphs of very different difficulty.
+//
+// Running one graph per thread leaves most threads idle at the end of a run, waiting for a few hard graphs,
+// whereas splitting every search into parallel subtasks adds overhead to the millions of graphs that take
+// microseconds. This file combines both, in a single work-stealing scheduler:
+//
+//      * every graph starts as a single task, which runs the one-pass search from find_gonality() (see
+//        divisors.h) with a limit of HYBRID_SPLIT_LEAVES leaves. Most graphs finish within this limit;
+//
+//      * a graph that exceeds the limit splits itself: the current level of the search (the superstable
+//        configurations of a given size) is divided into subtree tasks, one for every superstable
+//        assignment of chips to the vertices 1, ..., HYBRID_SPLIT_DEPTH. When all subtree tasks of a level
+//        are done, the last one creates the tasks for the next level (or finishes the graph);
+//
+//      * every thread has its own queue of tasks. A thread takes its own tasks newest first, then steals the
+//        oldest tasks from the other threads, and only then takes a new graph. So the idle threads help with
+//        the hard graphs first.
+//
+// The subtree tasks of a graph share the best divisor found so far (the bound of the branch and bound
+// search). To make the result independent of the timing, every task has a key that increases in the order
+// in which the sequential search would visit the subtrees, and a task may also return a divisor that is as
+// good as the best one so far if it comes from a task with a smaller key. So the gonality and the divisor
+// are always the same as with find_gonality().
+//
+// The main thread adds the graphs and reports the results in input order; at most HYBRID_WINDOW graphs are
+// in flight at any time.
+//
+// This file defines the following:
+//
+//      * class hybrid_scheduler
+//        The scheduler (see above). Call start() with the number of threads before adding graphs, and
+//        finish() after the last graph; the results are passed to the callback in input order. Use flush()
+//        to wait for the graphs added so far without stopping the threads.
+//
+
+#ifndef __HYBRID_SCHEDULER_H__
+#define __HYBRID_SCHEDULER_H__
+
+#include "graphs.h"
+#include "divisors.h"
+#include "alloc_stats.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <iostream>
+
+
+const int HYBRID_WINDOW = 256;                  // maximum number of graphs in flight
+const long long HYBRID_SPLIT_LEAVES = 20000;    // number of leaves after which a graph splits itself
+const int HYBRID_SPLIT_DEPTH = 3;               // number of vertices assigned by the subtree tasks
+
+
+
+class hybrid_scheduler {
+	struct slot {
+		my_graph G;
+		std::atomic<uint64_t> best;       // (value << 32) | key of the best divisor so far
+		std::mutex mutex;                 // protects divisor (and the updates of best)
+		std::vector<int> divisor;
+		std::atomic<int> outstanding;     // number of unfinished subtree tasks of the current level
+		unsigned next_key;                // key of the next subtree task
+		int gonality;
+		bool done;                        // protected by state_mutex
+	};
+
+	struct task {
+		int slot;
+		int size;                         // level of the subtree task (-1 for a graph task)
+		int remaining_chips;
+		int finished_vertices;
+		unsigned key;
+		int prefix[HYBRID_SPLIT_DEPTH + 1]; // chips on the vertices 1, ..., finished_vertices - 1
+	};
+
+	struct task_queue {
+		std::mutex mutex;
+		std::deque<task> tasks;
+	};
+
+	void (*done)(const my_graph&, const int, const int*);
+	slot* slots;
+	int first, count;                     // the graphs in flight are slots[first], ..., slots[first + count - 1] (cyclically)
+	std::vector<std::thread> threads;
+	task_queue* queues;                   // one per thread
+	task_queue new_graphs;
+	std::atomic<int> queued;              // total number of tasks in all queues
+	std::mutex work_mutex, state_mutex;
+	std::condition_variable work_cv, state_cv;
+	bool shutdown;                        // protected by work_mutex
+	long long split_leaves;
+
+	// Statistics.
+	std::atomic<long long> graphs, split_graphs, subtree_tasks, steals, leaves;
+
+	void push(task_queue& q, const task& t) {
+		{
+			std::lock_guard<std::mutex> lock(q.mutex);
+			q.tasks.push_back(t);
+		}
+		queued.fetch_add(1);
+		{
+			std::lock_guard<std::mutex> lock(work_mutex);
+		}
+		work_cv.notify_one();
+	}
+
+	bool try_pop(task_queue& q, task& t, bool newest) {
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (q.tasks.empty()) {
+			return false;
+		}
+		if (newest) {
+			t = q.tasks.back();
+			q.tasks.pop_back();
+		}
+		else {
+			t = q.tasks.front();
+			q.tasks.pop_front();
+		}
+		queued.fetch_sub(1);
+		return true;
+	}
+
+	// Get the next task for thread id (see above). Returns false when the scheduler shuts down.
+	bool next_task(const int id, task& t) {
+		const int num_threads = threads.size();
+		while (true) {
+			if (try_pop(queues[id], t, true)) {
+				return true;
+			}
+			for (int k = 1; k < num_threads; k++) {
+				if (try_pop(queues[(id + k) % num_threads], t, false)) {
+					steals++;
+					return true;
+				}
+			}
+			if (try_pop(new_graphs, t, false)) {
+				return true;
+			}
+			std::unique_lock<std::mutex> lock(work_mutex);
+			work_cv.wait(lock, [this] { return queued.load() > 0 || shutdown; });
+			if (shutdown && queued.load() == 0) {
+				return false;
+			}
+		}
+	}
+
+	void finish_graph(slot& s, const int gonality) {
+		std::lock_guard<std::mutex> lock(state_mutex);
+		s.gonality = gonality;
+		s.done = true;
+		state_cv.notify_all();
+	}
+
+	// Create the subtree tasks for the prefixes of the given level (cf. __one_pass_level()).
+	void generate(const int index, const int size, const int remaining_chips, const int finished_vertices, std::vector<task>& tasks) {
+		slot& s = slots[index];
+		if (remaining_chips == 0 || finished_vertices >= s.G.n || finished_vertices > HYBRID_SPLIT_DEPTH) {
+			if (remaining_chips > 0 && finished_vertices >= s.G.n) {
+				return;
+			}
+			task t;
+			t.slot = index;
+			t.size = size;
+			t.remaining_chips = remaining_chips;
+			t.finished_vertices = finished_vertices;
+			t.key = s.next_key++;
+			for (int v = 1; v < finished_vertices; v++) {
+				t.prefix[v] = __partial_divisor[v];
+			}
+			tasks.push_back(t);
+			return;
+		}
+		for (int i = remaining_chips; i >= 0; i--) {
+			__partial_divisor[finished_vertices] = i;
+			if (i == 0 || burn(s.G, __partial_divisor, 0) == 0) {
+				generate(index, size, remaining_chips - i, finished_vertices + 1, tasks);
+			}
+		}
+		__partial_divisor[finished_vertices] = 0;
+	}
+
+	// Start the given level of a split graph (or finish the graph if no better divisor can exist).
+	void start_level(const int id, const int index, int size) {
+		slot& s = slots[index];
+		std::vector<task> tasks;
+		while (tasks.empty()) {
+			const int best = s.best.load() >> 32;
+			if (size + 1 >= best) {
+				finish_graph(s, best);
+				return;
+			}
+			for (int i = 0; i < s.G.n; i++) {
+				__partial_divisor[i] = 0;
+			}
+			generate(index, size, size, 1, tasks);
+			size++;
+		}
+		s.outstanding.store(tasks.size());
+		subtree_tasks += tasks.size();
+		// The own thread takes its tasks newest first, so push them in reverse order.
+		for (int k = tasks.size() - 1; k >= 0; k--) {
+			push(queues[id], tasks[k]);
+		}
+	}
+
+	void run_graph_task(const int id, const task& t) {
+		slot& s = slots[t.slot];
+		const my_graph& G = s.G;
+		__search_leaves = 0;
+		__one_pass_best = G.n + 1;
+		__one_pass_aborted = false;
+		__one_pass_leaf_limit = split_leaves;
+		for (int i = 0; i < G.n; i++) {
+			__partial_divisor[i] = 0;
+		}
+		int size = 0;
+		for (; size + 1 < __one_pass_best; size++) {
+			if (__one_pass_level(G, size, size, 1)) {
+				break;
+			}
+		}
+		__one_pass_leaf_limit = -1;
+		leaves += __search_leaves;
+		if (__one_pass_best <= G.n) {
+			s.divisor.assign(__one_pass_best_divisor, __one_pass_best_divisor + G.n);
+		}
+		if (!__one_pass_aborted) {
+			finish_graph(s, __one_pass_best);
+			return;
+		}
+		// Split: redo the current level in subtree tasks, with the best divisor so far as the bound (key 0).
+		split_graphs++;
+		s.best.store((uint64_t) __one_pass_best << 32);
+		s.next_key = 1;
+		start_level(id, t.slot, size);
+	}
+
+	void run_subtree_task(const int id, const task& t) {
+		slot& s = slots[t.slot];
+		const my_graph& G = s.G;
+		const uint64_t best = s.best.load();
+		const int bound = (best >> 32) + (t.key < (best & 0xFFFFFFFFu) ? 1 : 0);
+		if (bound > t.size + 1) {
+			for (int i = 0; i < G.n; i++) {
+				__partial_divisor[i] = (i > 0 && i < t.finished_vertices ? t.prefix[i] : 0);
+			}
+			__search_leaves = 0;
+			__one_pass_best = bound;
+			__one_pass_level(G, t.size, t.remaining_chips, t.finished_vertices);
+			leaves += __search_leaves;
+			if (__one_pass_best < bound) {
+				const uint64_t found = ((uint64_t) __one_pass_best << 32) | t.key;
+				std::lock_guard<std::mutex> lock(s.mutex);
+				if (found < s.best.load()) {
+					s.best.store(found);
+					s.divisor.assign(__one_pass_best_divisor, __one_pass_best_divisor + G.n);
+				}
+			}
+		}
+		if (s.outstanding.fetch_sub(1) == 1) {
+			start_level(id, t.slot, t.size + 1);
+		}
+	}
+
+	void worker(const int id) {
+		task t;
+		while (next_task(id, t)) {
+			if (t.size == -1) {
+				run_graph_task(id, t);
+			}
+			else {
+				run_subtree_task(id, t);
+			}
+		}
+	}
+
+	// Report all finished graphs at the front of the window (main thread only).
+	void report(const bool wait_for_first) {
+		while (count > 0) {
+			slot& s = slots[first];
+			{
+				std::unique_lock<std::mutex> lock(state_mutex);
+				if (wait_for_first) {
+					state_cv.wait(lock, [&s] { return s.done; });
+				}
+				else if (!s.done) {
+					return;
+				}
+			}
+			done(s.G, s.gonality, s.divisor.data());
+			first = (first + 1) % HYBRID_WINDOW;
+			count--;
+			if (wait_for_first) {
+				return;
+			}
+		}
+	}
+
+public:
+	hybrid_scheduler(void (*_done)(const my_graph&, const int, const int*)) : done(_done), slots(NULL), first(0), count(0), queues(NULL),
+			queued(0), shutdown(false), split_leaves(HYBRID_SPLIT_LEAVES), graphs(0), split_graphs(0), subtree_tasks(0), steals(0), leaves(0) {}
+
+	~hybrid_scheduler() {
+		if (!threads.empty() && !shutdown) {
+			finish();
+		}
+		delete[] slots;
+		delete[] queues;
+	}
+
+	// Start the given number of worker threads (at least 1). Graphs are split after _split_leaves leaves.
+	void start(const int num_threads, const long long _split_leaves = HYBRID_SPLIT_LEAVES) {
+		assert(num_threads >= 1);
+		if (num_threads < 1) {
+			fprintf(stderr, "ERROR: hybrid_scheduler needs at least one thread (got %d).\n", num_threads);
+			exit(1);
+		}
+		assert(_split_leaves >= 1 && threads.empty());
+		split_leaves = _split_leaves;
+		slots = new slot[HYBRID_WINDOW];
+		queues = new task_queue[num_threads];
+		for (int i = 0; i < num_threads; i++) {
+			threads.push_back(std::thread());
+		}
+		for (int i = 0; i < num_threads; i++) {
+			threads[i] = std::thread(&hybrid_scheduler::worker, this, i);
+		}
+	}
+
+	void add(const my_graph& G) {
+		assert(!threads.empty());
+		report(false);
+		if (count == HYBRID_WINDOW) {
+			report(true);
+		}
+		const int index = (first + count) % HYBRID_WINDOW;
+		slot& s = slots[index];
+		{
+			ALLOC_PHASE("graph copy");
+			s.G.init();
+			s.G.setN(G.n);
+			for (int i = 0; i < G.n; i++) {
+				s.G.neighbours[i] = G.neighbours[i];
+			}
+			s.G.graph_name = G.graph_name;
+		}
+		s.best.store((uint64_t) (G.n + 1) << 32);
+		s.divisor.clear();
+		s.outstanding.store(0);
+		s.next_key = 1;
+		s.done = false;
+		count++;
+		graphs++;
+		task t;
+		t.slot = index;
+		t.size = -1;
+		push(new_graphs, t);
+	}
+
+	// Wait for all graphs and report them.
+	void flush() {
+		while (count > 0) {
+			report(true);
+		}
+	}
+
+	// Wait for all graphs, report them, and stop the worker threads.
+	void finish() {
+		flush();
+		{
+			std::lock_guard<std::mutex> lock(work_mutex);
+			shutdown = true;
+		}
+		work_cv.notify_all();
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+	}
+
+	void print_statistics(std::ostream& os) {
+		os << "Scheduler: " << threads.size() << " threads; " << graphs << " graphs, of which " << split_graphs << " were split into " << subtree_tasks << " subtree tasks; " << steals << " tasks stolen; " << leaves << " leaves." << std::endl;
+	}
+};
+
+
+#endif
@@ -0,0 +1,253 @@
+// Parallel version of has_positive_rank() for very large graphs (e.g. high order subdivisions).
+//
+// For a graph on n vertices, has_positive_rank() needs up to n runs of Dhar's burning algorithm, each
+// taking O(m) time. For graphs with a thousand vertices or more, a single call can take tens of
+// milliseconds, so it pays off to distribute the target vertices over several threads:
+//
+//      * every thread has its own copy of the divisor and of the workspace for the burning algorithm;
+//
+//      * the threads repeatedly claim the next target vertex u that has not been reached yet, and fire
+//        their own copy of the divisor towards u (exactly as in has_positive_rank());
+//
+//      * the set of vertices that can be reached (i.e. that receive a chip in some divisor equivalent
+//        to the input) is shared between the threads, and updated atomically. This is correct because
+//        all copies of the divisor remain linearly equivalent to the input divisor;
+//
+//      * as soon as one thread finds a target that cannot be reached, all threads abort.
+//
+// Simply including this file is enough: it installs itself as the implementation of has_positive_rank()
+// for graphs with at least PARALLEL_RANK_MIN_N vertices (see divisors.h), and it is also used by the
+// one-pass search find_gonality() for such graphs (see __min_chips_on_v0()), provided that the machine has
+// more than one hardware thread. By default, it uses all hardware threads; the programs that include it
+// have an option -R to choose the number of threads (or to disable the parallel check with -R 1), e.g. when
+// several processes share a machine. The worker threads are only started when they are first needed. The
+// calling thread takes part in the work, so no time is wasted waiting.
+//
+// Only one parallel check can be running at any time. If has_positive_rank() is called from several
+// threads at once, the other callers fall back to the sequential algorithm.
+//
+// This file defines the following functions:
+//
+//      * void parallel_rank_configure(int num_threads, int min_n)
+//        Change the number of threads and the size threshold (or disable the parallel check).
+//
+//      * int parallel_has_positive_rank(const my_graph& G, const int* divisor)
+//        The parallel check itself (see above; returns -1 if another parallel check is running).
+//
+
+#ifndef __PARALLEL_RANK_H__
+#define __PARALLEL_RANK_H__
+
+#include "graphs.h"
+#include "divisors.h"
+#include <cassert>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+
+const int PARALLEL_RANK_MIN_N = 400; // use the parallel check for graphs with at least this many vertices
+
+
+
+// Per-thread copy of the divisor, and workspace for the burning algorithm.
+struct __rank_worker {
+	std::vector<int> divisor;
+	std::vector<int> burnt_edges;
+	std::vector<int> queue;
+	std::vector<char> pushed_to_queue;
+
+	void resize() {
+		divisor.resize(MAX_N);
+		burnt_edges.resize(MAX_N);
+		queue.resize(MAX_N);
+		pushed_to_queue.resize(MAX_N);
+	}
+
+	// Dhar's burning algorithm on the own copy of the divisor (cf. burn() in divisors.h). Afterwards, the
+	// vertices in the firing set are the vertices with pushed_to_queue[v] == false. Returns the size of the
+	// firing set.
+	int burn(const my_graph& G, const int start) {
+		for (int i = 0; i < G.n; i++) {
+			pushed_to_queue[i] = false;
+			burnt_edges[i] = 0;
+		}
+		int head = 0, tail = 0;
+		queue[tail++] = start;
+		pushed_to_queue[start] = true;
+		while (head < tail) {
+			int i = queue[head++];
+			for (auto j : G.neighbours[i]) {
+				burnt_edges[j]++;
+				if (burnt_edges[j] > divisor[j] && !pushed_to_queue[j]) {
+					queue[tail++] = j;
+					pushed_to_queue[j] = true;
+				}
+			}
+		}
+		return G.n - tail;
+	}
+};
+
+
+// State shared between the threads.
+struct __parallel_rank_state {
+	std::mutex busy;                 // held by the thread that is running a parallel check
+	std::mutex mutex;                // protects the fields below (except the atomics)
+	std::condition_variable start_cv, done_cv;
+	std::vector<std::thread> threads;
+	std::vector<__rank_worker> workers;
+	int num_threads;
+	long long generation;            // incremented for every new check
+	int running;                     // number of helper threads still working on the current check
+
+	// Current check.
+	const my_graph* G;
+	const int* divisor;
+	std::atomic<int> next_target;
+	std::atomic<bool> failed;
+	std::atomic<bool> can_reach[MAX_N];
+
+	__parallel_rank_state() : num_threads(0), generation(0), running(0), G(NULL), divisor(NULL), next_target(0), failed(false) {}
+};
+
+// The helper threads are detached and sleep on the condition variables until the program exits, so the
+// shared state is deliberately never destroyed.
+__parallel_rank_state& __parallel_rank = *new __parallel_rank_state();
+
+
+// The work done by every thread (including the calling thread) for the current check.
+void __parallel_rank_work(__rank_worker& w) {
+	const my_graph& G = *__parallel_rank.G;
+	for (int i = 0; i < G.n; i++) {
+		w.divisor[i] = __parallel_rank.divisor[i];
+	}
+	while (!__parallel_rank.failed.load(std::memory_order_relaxed)) {
+		const int u = __parallel_rank.next_target.fetch_add(1);
+		if (u >= G.n) {
+			return;
+		}
+		while (!__parallel_rank.can_reach[u].load(std::memory_order_relaxed)) {
+			if (__parallel_rank.failed.load(std::memory_order_relaxed)) {
+				return;
+			}
+			if (w.divisor[u] > 0) {
+				__parallel_rank.can_reach[u].store(true, std::memory_order_relaxed);
+				break;
+			}
+			if (w.burn(G, u) == 0) {
+				__parallel_rank.failed.store(true, std::memory_order_relaxed);
+				return;
+			}
+			for (int v = 0; v < G.n; v++) {
+				if (!w.pushed_to_queue[v]) {
+					// v is in the firing set
+					for (auto x : G.neighbours[v]) {
+						w.divisor[v]--;
+						w.divisor[x]++;
+					}
+				}
+			}
+			// record intermediate steps to save time (for all threads)
+			for (int v = 0; v < G.n; v++) {
+				if (w.divisor[v] > 0 && !__parallel_rank.can_reach[v].load(std::memory_order_relaxed)) {
+					__parallel_rank.can_reach[v].store(true, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+}
+
+void __parallel_rank_thread(int id) {
+	long long seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(__parallel_rank.mutex);
+			while (__parallel_rank.generation == seen) {
+				__parallel_rank.start_cv.wait(lock);
+			}
+			seen = __parallel_rank.generation;
+		}
+		__parallel_rank_work(__parallel_rank.workers[id]);
+		{
+			std::lock_guard<std::mutex> lock(__parallel_rank.mutex);
+			__parallel_rank.running--;
+			if (__parallel_rank.running == 0) {
+				__parallel_rank.done_cv.notify_one();
+			}
+		}
+	}
+}
+
+
+// Parallel positive rank check (see the description at the top of this file).
+// Returns 1 if the divisor has positive rank, 0 if not, and -1 if another parallel check is running.
+int parallel_has_positive_rank(const my_graph& G, const int* divisor) {
+	std::unique_lock<std::mutex> busy(__parallel_rank.busy, std::try_to_lock);
+	if (!busy.owns_lock()) {
+		return -1;
+	}
+	assert(__parallel_rank.num_threads >= 1);
+	// Start the helper threads on first use. They are never stopped (they sleep while not in use).
+	if (__parallel_rank.threads.empty()) {
+		__parallel_rank.workers.resize(__parallel_rank.num_threads);
+		for (int i = 0; i < __parallel_rank.num_threads; i++) {
+			__parallel_rank.workers[i].resize();
+		}
+		for (int i = 1; i < __parallel_rank.num_threads; i++) {
+			__parallel_rank.threads.push_back(std::thread(__parallel_rank_thread, i));
+			__parallel_rank.threads.back().detach();
+		}
+	}
+	for (int i = 0; i < G.n; i++) {
+		assert(divisor[i] >= 0);
+		__parallel_rank.can_reach[i].store(divisor[i] > 0, std::memory_order_relaxed);
+	}
+	__parallel_rank.G = &G;
+	__parallel_rank.divisor = divisor;
+	__parallel_rank.next_target.store(0);
+	__parallel_rank.failed.store(false);
+	{
+		std::lock_guard<std::mutex> lock(__parallel_rank.mutex);
+		__parallel_rank.running = __parallel_rank.num_threads - 1;
+		__parallel_rank.generation++;
+		__parallel_rank.start_cv.notify_all();
+	}
+	__parallel_rank_work(__parallel_rank.workers[0]);
+	{
+		std::unique_lock<std::mutex> lock(__parallel_rank.mutex);
+		while (__parallel_rank.running > 0) {
+			__parallel_rank.done_cv.wait(lock);
+		}
+	}
+	return (__parallel_rank.failed.load() ? 0 : 1);
+}
+
+
+// Set the number of threads (including the calling thread) and the minimum number of vertices for which
+// the parallel check is used. With num_threads <= 1, the parallel check is disabled. The number of threads
+// can only be changed before the first parallel check.
+void parallel_rank_configure(int num_threads, int min_n) {
+	assert(__parallel_rank.threads.empty());
+	if (num_threads <= 1) {
+		__parallel_has_positive_rank = NULL;
+		__parallel_rank_min_n = MAX_N + 1;
+		return;
+	}
+	__parallel_rank.num_threads = num_threads;
+	__parallel_has_positive_rank = parallel_has_positive_rank;
+	__parallel_rank_min_n = min_n;
+}
+
+
+// Install the parallel check when this file is included (see above).
+struct __parallel_rank_installer {
+	__parallel_rank_installer() {
+		parallel_rank_configure(std::thread::hardware_concurrency(), PARALLEL_RANK_MIN_N);
+	}
+} __parallel_rank_installer_instance;
+
+
+#endif
@@ -0,0 +1,279 @@
+// Three-stage I/O pipeline (read → solve → write) for the programs that process many graphs.
+//
+// In the default (serial) mode, the programs read a graph, solve it, print the result and flush
+// the output before reading the next graph. This header splits this into three stages:
+//
+//      * a reader thread reads the input and decodes it into graphs (graph6 or plain format);
+//
+//      * the calling thread solves the graphs one by one, exactly as in serial mode;
+//
+//      * a writer thread owns a large output buffer, and writes it to the real standard output
+//        whenever it has nothing else to do (or when the buffer is full).
+//
+// The stages are connected by bounded single-producer single-consumer ring buffers (spsc_ring below),
+// so that neither the parser nor a slow output pipe can stall the solver (unless a ring is full).
+//
+// The solver does not need to be aware of any of this: while a graph is being solved, std::cout is
+// redirected to an in-memory buffer, which is handed to the writer thread once the graph is done.
+// Consequently, the output is byte-for-byte identical to the output in serial mode.
+//
+// Note on thread safety: the functions in divisors.h and graphs.h use global variables, so they must
+// only be called by the solver. The reader only uses the parse functions from graph6.h and graph_io.h,
+// which do not touch any of the global variables used by the solver.
+//
+// This file defines the following:
+//
+//      * template <typename T, size_t CAPACITY> class spsc_ring
+//        Bounded single-producer single-consumer ring buffer (blocking push and pop).
+//
+//      * class pipeline_writer
+//        Writer thread with a large output buffer; also takes care of redirecting std::cout.
+//
+//      * void read_and_process_pipelined(std::istream& is, bool graph6, void (*process_function)(const my_graph&), void (*finish_function)() = NULL)
+//        Pipelined replacement for the input loops of the programs (graph6 or plain input).
+//
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include "graphs.h"
+#include "graph6.h"
+#include "graph_io.h"
+#include "alloc_stats.h"
+#include <cassert>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <utility>
+#include <string>
+#include <sstream>
+#include <iostream>
+
+
+const size_t PIPELINE_RING_SIZE = 64;              // number of graphs (or output blocks) in flight between two stages
+const size_t PIPELINE_OUTPUT_BUFFER_SIZE = 1 << 20; // the writer writes its buffer to the output once it exceeds this size
+const int PIPELINE_SPIN_COUNT = 256;               // number of times to spin before going to sleep on an empty or full ring
+
+
+
+// Bounded single-producer single-consumer ring buffer.
+//
+// The indices are only ever advanced by one thread each (tail by the producer, head by the consumer),
+// so the fast path is lock-free. A thread that finds the ring full (producer) or empty (consumer) spins
+// for a little while, and then goes to sleep on a condition variable until the other side catches up.
+//
+// Once the producer calls close(), the consumer can still pop the remaining elements, after which pop()
+// returns false.
+template <typename T, size_t CAPACITY>
+class spsc_ring {
+	T slots[CAPACITY];
+	std::atomic<size_t> head; // index of the next element to be popped
+	std::atomic<size_t> tail; // index of the next element to be pushed
+	std::atomic<bool> closed;
+	std::atomic<int> sleepers;
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_cv;
+
+	void wake_up() {
+		if (sleepers.load() > 0) {
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			sleep_cv.notify_all();
+		}
+	}
+
+	template <typename Predicate>
+	void wait_until(Predicate ready) {
+		for (int i = 0; i < PIPELINE_SPIN_COUNT; i++) {
+			if (ready()) {
+				return;
+			}
+			std::this_thread::yield();
+		}
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleepers++;
+		while (!ready()) {
+			sleep_cv.wait(lock);
+		}
+		sleepers--;
+	}
+
+public:
+	spsc_ring() : head(0), tail(0), closed(false), sleepers(0) {}
+
+	// Append an element; blocks while the ring is full.
+	void push(T&& x) {
+		const size_t t = tail.load(std::memory_order_relaxed);
+		wait_until([&]() { return t - head.load() < CAPACITY; });
+		slots[t % CAPACITY] = std::move(x);
+		tail.store(t + 1);
+		wake_up();
+	}
+
+	// Remove the oldest element; blocks while the ring is empty. Returns false if the ring is empty and closed.
+	bool pop(T& x) {
+		const size_t h = head.load(std::memory_order_relaxed);
+		wait_until([&]() { return tail.load() != h || closed.load(); });
+		if (tail.load() == h) {
+			assert(closed.load());
+			return false;
+		}
+		x = std::move(slots[h % CAPACITY]);
+		head.store(h + 1);
+		wake_up();
+		return true;
+	}
+
+	// Non-blocking check (only meaningful for the consumer).
+	bool empty() const {
+		return tail.load() == head.load(std::memory_order_relaxed);
+	}
+
+	// Signal that no further elements will be pushed.
+	void close() {
+		closed.store(true);
+		wake_up();
+	}
+};
+
+
+
+// Writer thread.
+//
+// Between calls to capture_begin() and capture_end(), everything written to std::cout is stored in
+// memory. The function capture_end() hands the captured output to the writer thread, which appends it
+// to its own buffer and writes this buffer to the original std::cout stream buffer whenever the ring
+// runs empty or the buffer grows beyond PIPELINE_OUTPUT_BUFFER_SIZE. Blocking writes to a slow pipe
+// therefore only stall the writer thread, and not the solver.
+class pipeline_writer {
+	spsc_ring<std::string, PIPELINE_RING_SIZE> ring;
+	std::stringbuf capture_buffer;
+	std::streambuf* original_buffer;
+	std::thread thread;
+
+	void run() {
+		std::string buffer, block;
+		buffer.reserve(PIPELINE_OUTPUT_BUFFER_SIZE);
+		while (ring.pop(block)) {
+			buffer.append(block);
+			if (buffer.size() >= PIPELINE_OUTPUT_BUFFER_SIZE || ring.empty()) {
+				original_buffer->sputn(buffer.data(), buffer.size());
+				original_buffer->pubsync();
+				buffer.clear();
+			}
+		}
+		original_buffer->sputn(buffer.data(), buffer.size());
+		original_buffer->pubsync();
+	}
+
+public:
+	pipeline_writer() : original_buffer(std::cout.rdbuf()) {
+		std::cout.flush();
+		thread = std::thread(&pipeline_writer::run, this);
+	}
+
+	// Start capturing std::cout (must be called by the solver thread).
+	void capture_begin() {
+		std::cout.rdbuf(&capture_buffer);
+	}
+
+	// Stop capturing std::cout, and pass the captured output on to the writer thread.
+	void capture_end() {
+		std::cout.rdbuf(original_buffer);
+		std::string block = capture_buffer.str();
+		capture_buffer.str(std::string());
+		if (!block.empty()) {
+			ring.push(std::move(block));
+		}
+	}
+
+	// Write all remaining output and stop the writer thread. Afterwards, std::cout can be used as usual.
+	void finish() {
+		ring.close();
+		thread.join();
+	}
+};
+
+
+
+// Pipelined input loop.
+//
+// Reads graphs from the given stream (graph6 format if the second argument is true, otherwise the
+// plain format from graph_io.h) on a separate thread, and calls process_function on the calling thread
+// for every graph, in the order of the input. Output is passed through a pipeline_writer (see above).
+// If finish_function is given, it is called (on the calling thread, with output captured) after the last
+// graph; this is useful if process_function does not finish every graph immediately.
+//
+// To avoid memory allocation in the steady state, the graphs are stored in a fixed pool which is
+// recycled through a second ring buffer.
+
+const size_t __PIPELINE_POOL_SIZE = PIPELINE_RING_SIZE + 2;
+my_graph* __pipeline_pool;
+spsc_ring<my_graph*, PIPELINE_RING_SIZE> __pipeline_full_graphs;
+spsc_ring<my_graph*, __PIPELINE_POOL_SIZE> __pipeline_free_graphs;
+
+void __pipeline_copy_graph(const my_graph& G, my_graph& ret) {
+	ALLOC_PHASE("graph copy");
+	ret.init();
+	ret.setN(G.n);
+	for (int i = 0; i < G.n; i++) {
+		ret.neighbours[i] = G.neighbours[i];
+	}
+	ret.graph_name = G.graph_name;
+}
+
+void __pipeline_push_plain_graph(const my_graph& G) {
+	my_graph* slot = NULL;
+	bool ok = __pipeline_free_graphs.pop(slot);
+	assert(ok);
+	(void) ok;
+	__pipeline_copy_graph(G, *slot);
+	__pipeline_full_graphs.push(std::move(slot));
+}
+
+void __pipeline_read(std::istream* is, bool graph6) {
+	if (graph6) {
+		std::string s;
+		while (std::getline(*is, s)) {
+			my_graph* slot = NULL;
+			bool ok = __pipeline_free_graphs.pop(slot);
+			assert(ok);
+			(void) ok;
+			parse_graph6(s, *slot);
+			slot->graph_name = s;
+			__pipeline_full_graphs.push(std::move(slot));
+		}
+	}
+	else {
+		read_plain_input_and_process(*is, __pipeline_push_plain_graph);
+	}
+	__pipeline_full_graphs.close();
+}
+
+void read_and_process_pipelined(std::istream& is, bool graph6, void (*process_function)(const my_graph&), void (*finish_function)() = NULL) {
+	__pipeline_pool = new my_graph[__PIPELINE_POOL_SIZE];
+	for (size_t i = 0; i < __PIPELINE_POOL_SIZE; i++) {
+		my_graph* slot = __pipeline_pool + i;
+		__pipeline_free_graphs.push(std::move(slot));
+	}
+	pipeline_writer writer;
+	std::thread reader(__pipeline_read, &is, graph6);
+	my_graph* G;
+	while (__pipeline_full_graphs.pop(G)) {
+		writer.capture_begin();
+		process_function(*G);
+		writer.capture_end();
+		__pipeline_free_graphs.push(std::move(G));
+	}
+	if (finish_function != NULL) {
+		writer.capture_begin();
+		finish_function();
+		writer.capture_end();
+	}
+	reader.join();
+	writer.finish();
+	delete[] __pipeline_pool;
+}
+
+
+#endif
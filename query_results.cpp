@@ -0,0 +1,239 @@
+// This program reads one or more binary results files (as written by Brill_Noether_geng -o and
+// subdivision_conjecture -o; see results_db.h), and either lists the graphs satisfying the given
+// criteria, or counts them per number of vertices and edges.
+//
+// Usage:
+//       ./query_results [-cftb] [-G genus] [-s stage] file [file ...]
+//
+//       Selection options (all given criteria must be satisfied):
+//       -G g     : only graphs of (algebraic) genus g
+//       -s stage : only graphs that were decided at the given stage (1 = leaf, 2 = trivial bound,
+//                  3 = independent set, 4 = brute force)
+//       -b       : only graphs for which the gonality was computed (same as -s 4)
+//       -t       : only graphs whose gonality equals the Brill–Noether bound
+//       -f       : only graphs that fail the Brill–Noether or subdivision conjecture
+//
+//       Output options:
+//       -c       : count the selected graphs per (n, m) instead of listing them
+//
+// The files are mapped into memory, so they can be queried without reading them into memory first.
+// In list mode, every selected graph is printed as a line "res/mod ordinal n m genus stage gonality bound",
+// where res/mod and ordinal identify the graph in the enumeration (i.e. it is the ordinal-th graph in the
+// output of geng with the same arguments and shard res/mod). A gonality of 0 means "not computed".
+
+
+#define USAGE_STRING \
+"query_results [-cftb] [-G genus] [-s stage] file [file ...]"
+
+#define HELPTEXT \
+" List or count the graphs in the given results files.\n\
+\n\
+\n\
+    Selection options:\n\
+       -G g     : only graphs of genus g\n\
+       -s stage : only graphs decided at the given stage (1 = leaf, 2 = trivial bound,\n\
+                  3 = independent set, 4 = brute force)\n\
+       -b       : only graphs for which the gonality was computed (same as -s 4)\n\
+       -t       : only graphs whose gonality equals the Brill–Noether bound\n\
+       -f       : only graphs that fail the Brill–Noether or subdivision conjecture\n\
+\n\
+    Output options:\n\
+       -c       : count the selected graphs per (n, m) instead of listing them\n\
+\n\
+  See program text for much more information.\n"
+
+
+#include "results_db.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <sys/mman.h>
+
+using namespace std;
+
+bool arg_c = false;
+bool arg_t = false;
+bool arg_f = false;
+int arg_G = -1;
+int arg_s = -1;
+
+// Per (n, m): number of selected graphs, number of selected graphs per stage.
+map<pair<int, int>, vector<long long> > counts;
+long long count_selected = 0;
+
+bool selected(const results_db_record& r) {
+	const int genus = (int) r.m - (int) r.n + 1;
+	if (arg_G != -1 && genus != arg_G) {
+		return false;
+	}
+	if (arg_s != -1 && r.stage != arg_s) {
+		return false;
+	}
+	if (arg_t && (r.gonality == 0 || r.gonality != r.BN_bound)) {
+		return false;
+	}
+	if (arg_f && r.flags == 0) {
+		return false;
+	}
+	return true;
+}
+
+void process_file(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		perror("open");
+		cerr << "Error: cannot open \"" << path << "\"." << endl;
+		exit(1);
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(results_db_header)) {
+		cerr << "Error: \"" << path << "\" is not a results file." << endl;
+		exit(1);
+	}
+	const size_t size = st.st_size;
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	close(fd);
+	madvise(data, size, MADV_SEQUENTIAL);
+	const results_db_header* h = (const results_db_header*) data;
+	if (!results_db_header_ok(*h)) {
+		cerr << "Error: \"" << path << "\" is not a results file, or was written by an incompatible version." << endl;
+		exit(1);
+	}
+	const size_t num_records = (size - sizeof(results_db_header)) / sizeof(results_db_record);
+	if ((size - sizeof(results_db_header)) % sizeof(results_db_record) != 0) {
+		cerr << "Warning: \"" << path << "\" ends with an incomplete record (interrupted write?). Ignoring it." << endl;
+	}
+	const results_db_record* records = (const results_db_record*) ((const char*) data + sizeof(results_db_header));
+	// Check all records before printing anything, so that a corrupt file is rejected as a whole.
+	for (size_t i = 0; i < num_records; i++) {
+		const results_db_record& r = records[i];
+		if (!results_db_record_ok(*h, r)) {
+			cerr << "Error: record " << i + 1 << " of \"" << path << "\" is invalid (n = " << r.n << ", m = " << r.m << ", stage " << (int) r.stage;
+			cerr << ", gonality " << (int) r.gonality << "); the file is corrupt, or was not written by this code." << endl;
+			exit(1);
+		}
+	}
+	for (size_t i = 0; i < num_records; i++) {
+		const results_db_record& r = records[i];
+		if (!selected(r)) {
+			continue;
+		}
+		count_selected++;
+		if (arg_c) {
+			vector<long long>& v = counts[make_pair((int) r.n, (int) r.m)];
+			v.resize(STAGE_BRUTE_FORCE + 2, 0);
+			v[0]++;
+			v[r.stage + 1]++;
+		}
+		else {
+			printf("%d/%d %llu %d %d %d %d %d %d\n", h->res, h->mod, (unsigned long long) r.ordinal, r.n, r.m, (int) r.m - (int) r.n + 1, r.stage, r.gonality, r.BN_bound);
+		}
+	}
+	munmap(data, size);
+}
+
+void usage() {
+	cerr << endl;
+	cerr << "Usage: " << USAGE_STRING << endl;
+	cerr << endl;
+	cerr << HELPTEXT << endl;
+}
+
+int parse_nonnegative_int(const char* s) {
+	int x;
+	char tmp[30];
+	if (sscanf(s, "%d", &x) != 1 || x < 0) {
+		return -1;
+	}
+	sprintf(tmp, "%d", x);
+	return (strcmp(s, tmp) ? -1 : x);
+}
+
+int main(int argc, char* argv[]) {
+	// Parse command-line arguments
+	bool badargs = false;
+	bool arg_h = false;
+	vector<const char*> files;
+	for (int i = 1; i < argc && !badargs; i++) {
+		unsigned l = strlen(argv[i]);
+		assert(l >= 1);
+		if (argv[i][0] == '-') {
+			for (unsigned j = 1; j < l && !badargs; j++) {
+				switch (argv[i][j]) {
+					case 'h':
+						arg_h = true;
+						break;
+					case 'c':
+						arg_c = true;
+						break;
+					case 't':
+						arg_t = true;
+						break;
+					case 'f':
+						arg_f = true;
+						break;
+					case 'b':
+						arg_s = STAGE_BRUTE_FORCE;
+						break;
+					case 'G':
+					case 's':
+						// the value is the next argument
+						if (j + 1 != l || i + 1 >= argc) {
+							badargs = true;
+						}
+						else {
+							int& target = (argv[i][j] == 'G' ? arg_G : arg_s);
+							target = parse_nonnegative_int(argv[++i]);
+							badargs = (target == -1);
+						}
+						break;
+					default:
+						badargs = true;
+						break;
+				}
+			}
+		}
+		else {
+			files.push_back(argv[i]);
+		}
+	}
+	if (!badargs && arg_s != -1 && (arg_s < STAGE_LEAF || arg_s > STAGE_BRUTE_FORCE)) {
+		cerr << "Error: the stage should be between " << STAGE_LEAF << " and " << STAGE_BRUTE_FORCE << "." << endl;
+		badargs = true;
+	}
+	if (!arg_h && !badargs && files.empty()) {
+		cerr << "Error: no results files given." << endl;
+		badargs = true;
+	}
+	if (arg_h || badargs) {
+		cerr << (badargs ? "Invalid argument(s)." : "Requested help.") << endl;
+		usage();
+		exit(badargs ? 1 : 0);
+	}
+
+	// Process files
+	for (size_t i = 0; i < files.size(); i++) {
+		process_file(files[i]);
+	}
+
+	// Print counts
+	if (arg_c) {
+		printf("%4s %4s %14s %14s %14s %14s %14s\n", "n", "m", "selected", "leaf", "trivial", "indep. set", "brute force");
+		for (map<pair<int, int>, vector<long long> >::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+			const vector<long long>& v = it->second;
+			printf("%4d %4d %14lld %14lld %14lld %14lld %14lld\n", it->first.first, it->first.second, v[0], v[STAGE_LEAF + 1], v[STAGE_TRIVIAL_BOUND + 1], v[STAGE_INDEPENDENT_SET + 1], v[STAGE_BRUTE_FORCE + 1]);
+		}
+		printf("Total: %lld graphs selected.\n", count_selected);
+	}
+	return 0;
+}
@@ -0,0 +1,259 @@
+// Compact binary store for the per-graph results of exhaustive enumerations.
+//
+// A results file consists of a fixed 40-byte header, followed by any number of fixed-width 16-byte
+// records (one per graph). The header identifies the enumeration (number of vertices, res/mod shard, and a
+// hash of a description of the input given by the program, e.g. the arguments passed to geng);
+// every record identifies its graph by its ordinal within the shard (i.e. the number printed as
+// "Graph <ordinal>" by the programs, which for Brill_Noether_geng is the position in the output of geng).
+// So a graph can always be recovered by running geng with the same arguments and picking the graph with
+// the right ordinal.
+//
+// Files are only appended to, except that a resumed enumeration (see shard_checkpoint.h) first truncates
+// the records written after its last checkpoint, as these graphs will be checked again. Records are
+// buffered in memory and written in blocks, and the file is synced to disk at least every
+// RESULTS_DB_SYNC_SECONDS seconds, so that at most a few minutes of work are lost if the machine goes
+// down. The results can be read back (without re-running anything) using the program query_results, which
+// maps the file into memory.
+//
+// A file that already contains records is only reopened when resuming; otherwise the program refuses to
+// run, as appending would store every graph twice. The values in a record are checked at runtime: a graph
+// whose values do not fit (e.g. more than 65535 edges, or a gonality above 255) is a fatal error. Readers
+// check every record with results_db_record_ok(), and reject files with invalid records.
+//
+// All fields are stored in native byte order; the header records the size of a record, so that a file
+// written by an incompatible version of this code will be rejected rather than misinterpreted.
+//
+// Requires POSIX (open/write/fsync).
+
+#ifndef __RESULTS_DB_H__
+#define __RESULTS_DB_H__
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+const char RESULTS_DB_MAGIC[8] = {'D', 'G', 'O', 'N', 'R', 'E', 'S', '\0'};
+const uint32_t RESULTS_DB_VERSION = 2;
+const size_t RESULTS_DB_BUFFER_RECORDS = 4096; // number of records to collect before writing them to disk
+const time_t RESULTS_DB_SYNC_SECONDS = 60;     // maximum time between two calls to fsync()
+
+// The stage at which the verdict for a graph was reached (see Brill_Noether_geng.cpp for the filters).
+enum results_db_stage {
+	STAGE_NONE = 0,
+	STAGE_LEAF = 1,            // graph has a vertex of degree 1 (skipped)
+	STAGE_TRIVIAL_BOUND = 2,   // Brill–Noether bound is trivially met (skipped)
+	STAGE_INDEPENDENT_SET = 3, // a large enough independent set was found (skipped)
+	STAGE_BRUTE_FORCE = 4      // gonality was computed
+};
+
+// Flags (bitwise or).
+const uint8_t RESULT_FAILS_BRILL_NOETHER = 1;
+const uint8_t RESULT_FAILS_SUBDIVISION = 2;
+
+struct results_db_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	int32_t n;   // number of vertices (0 if the file contains graphs of different sizes)
+	int32_t res; // shard res/mod (0/1 if the enumeration is not sharded)
+	int32_t mod;
+	int32_t reserved;
+	uint64_t input_id; // see results_db_input_id()
+};
+
+struct results_db_record {
+	uint64_t ordinal;   // position of the graph in the enumeration (starting at 1)
+	uint16_t n;         // number of vertices
+	uint16_t m;         // number of edges
+	uint8_t stage;      // see results_db_stage
+	uint8_t gonality;   // 0 if not computed
+	uint8_t BN_bound;   // Brill–Noether bound floor((g + 3) / 2)
+	uint8_t flags;      // see RESULT_* above
+};
+
+static_assert(sizeof(results_db_header) == 40, "unexpected size of results_db_header");
+static_assert(sizeof(results_db_record) == 16, "unexpected size of results_db_record");
+
+
+// Check whether a header is valid and was written by a compatible version of this code.
+bool results_db_header_ok(const results_db_header& h) {
+	return memcmp(h.magic, RESULTS_DB_MAGIC, sizeof RESULTS_DB_MAGIC) == 0 && h.version == RESULTS_DB_VERSION && h.record_size == sizeof(results_db_record);
+}
+
+
+// Check whether the values in a record are valid: a known stage, a graph with at least one vertex (and with
+// the number of vertices given in the header, if any), and a gonality of at most the number of vertices.
+bool results_db_record_ok(const results_db_header& h, const results_db_record& r) {
+	return r.stage >= STAGE_LEAF && r.stage <= STAGE_BRUTE_FORCE && r.n >= 1 && (h.n == 0 || r.n == h.n) && r.gonality <= r.n;
+}
+
+
+// Identity of the input, for the header: a hash (64-bit FNV-1a) of a description of the input.
+uint64_t results_db_input_id(const std::string& description) {
+	uint64_t h = 14695981039346656037ULL;
+	for (unsigned char c : description) {
+		h ^= c;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+
+// Append-only writer.
+//
+// If the file does not exist yet, it is created and a header is written. If it does exist, its header
+// must match the given enumeration and input, and it may only contain records if the enumeration is being
+// resumed (see above); new records are then appended to the existing ones. Errors (e.g. disk full) are
+// fatal, as the results file would otherwise silently become incomplete.
+class results_db_writer {
+	int fd;
+	std::string path;
+	std::vector<results_db_record> buffer;
+	uint64_t written;   // number of records in the file (excluding the buffer)
+	time_t last_sync;
+
+	void fail(const char* what) {
+		perror(what);
+		fprintf(stderr, ">E Error: failed to write results file \"%s\".\n", path.c_str());
+		exit(1);
+	}
+
+	void write_all(const void* data, size_t size) {
+		const char* p = (const char*) data;
+		while (size > 0) {
+			ssize_t written = write(fd, p, size);
+			if (written < 0) {
+				fail("write");
+			}
+			p += written;
+			size -= written;
+		}
+	}
+
+public:
+	results_db_writer() : fd(-1), written(0), last_sync(0) {}
+
+	~results_db_writer() {
+		close();
+	}
+
+	void open(const std::string& _path, int n, int res, int mod, uint64_t input_id, bool resume) {
+		assert(fd == -1);
+		path = _path;
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+		if (fd == -1) {
+			fail("open");
+		}
+		results_db_header h;
+		ssize_t got = pread(fd, &h, sizeof h, 0);
+		if (got == 0) {
+			memset(&h, 0, sizeof h);
+			memcpy(h.magic, RESULTS_DB_MAGIC, sizeof RESULTS_DB_MAGIC);
+			h.version = RESULTS_DB_VERSION;
+			h.record_size = sizeof(results_db_record);
+			h.n = n;
+			h.res = res;
+			h.mod = mod;
+			h.input_id = input_id;
+			write_all(&h, sizeof h);
+		}
+		else if (got != sizeof h || !results_db_header_ok(h) || h.n != n || h.res != res || h.mod != mod || h.input_id != input_id) {
+			fprintf(stderr, ">E Error: results file \"%s\" exists, but belongs to a different enumeration or input.\n", path.c_str());
+			exit(1);
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			fail("fstat");
+		}
+		written = (st.st_size - sizeof h) / sizeof(results_db_record);
+		if (written > 0 && !resume) {
+			fprintf(stderr, ">E Error: results file \"%s\" already contains results; remove it first.\n", path.c_str());
+			exit(1);
+		}
+		buffer.reserve(RESULTS_DB_BUFFER_RECORDS);
+		last_sync = time(NULL);
+	}
+
+	bool is_open() const {
+		return fd != -1;
+	}
+
+	// Number of records appended so far (including the records in the file when it was opened).
+	uint64_t records() const {
+		return written + buffer.size();
+	}
+
+	// Discard all records after the first "keep" ones (only used when resuming from a checkpoint).
+	void truncate(uint64_t keep) {
+		assert(fd != -1);
+		flush();
+		if (keep > written) {
+			fprintf(stderr, ">E Error: results file \"%s\" has fewer records than expected.\n", path.c_str());
+			exit(1);
+		}
+		if (ftruncate(fd, sizeof(results_db_header) + keep * sizeof(results_db_record)) != 0) {
+			fail("ftruncate");
+		}
+		written = keep;
+	}
+
+	// Append a record (see results_db_record for the fields). Values that do not fit are a fatal error.
+	void append(uint64_t ordinal, long long n, long long m, int stage, long long gonality, long long BN_bound, uint8_t flags) {
+		assert(fd != -1);
+		if (n < 1 || n > UINT16_MAX || m < 0 || m > UINT16_MAX || stage < STAGE_LEAF || stage > STAGE_BRUTE_FORCE
+				|| gonality < 0 || gonality > UINT8_MAX || gonality > n || BN_bound < 0 || BN_bound > UINT8_MAX) {
+			fprintf(stderr, ">E Error: graph %llu (n = %lld, m = %lld, stage %d, gonality %lld) does not fit in the results file \"%s\".\n",
+					(unsigned long long) ordinal, n, m, stage, gonality, path.c_str());
+			exit(1);
+		}
+		results_db_record r;
+		r.ordinal = ordinal;
+		r.n = n;
+		r.m = m;
+		r.stage = stage;
+		r.gonality = gonality;
+		r.BN_bound = BN_bound;
+		r.flags = flags;
+		buffer.push_back(r);
+		if (buffer.size() >= RESULTS_DB_BUFFER_RECORDS) {
+			flush();
+		}
+	}
+
+	// Write all buffered records, and sync the file to disk if this hasn't happened for a while.
+	void flush(bool force_sync = false) {
+		assert(fd != -1);
+		if (!buffer.empty()) {
+			write_all(buffer.data(), buffer.size() * sizeof(results_db_record));
+			written += buffer.size();
+			buffer.clear();
+		}
+		time_t now = time(NULL);
+		if (force_sync || now - last_sync >= RESULTS_DB_SYNC_SECONDS) {
+			if (fsync(fd) != 0) {
+				fail("fsync");
+			}
+			last_sync = now;
+		}
+	}
+
+	void close() {
+		if (fd != -1) {
+			flush(true);
+			::close(fd);
+			fd = -1;
+		}
+	}
+};
+
+
+#endif
@@ -0,0 +1,407 @@
+// Resumable (suspendable) searches for positive rank divisors and for the gonality, and a scheduler that
+// interleaves the gonality computations for several graphs.
+//
+// The recursive searches in find_positive_rank_divisor() and find_gonality() (divisors.h) cannot be
+// interrupted: once started, they run until they are finished. This file provides the same searches as
+// explicit state machines, which can be suspended after any number of leaves, resumed later, copied, or
+// written to a string and read back (e.g. to save them to disk).
+//
+// positive_rank_search visits the candidates in exactly the same order as find_positive_rank_divisor():
+// effective divisors of the requested degree with at least one chip on v0, in decreasing lexicographic
+// order. Its complete state is the next candidate divisor.
+//
+// gonality_search visits the superstable configurations in exactly the same order as the one-pass search
+// in find_gonality() (by increasing size, and in decreasing lexicographic order for every size, skipping
+// the extensions of partial configurations that are not superstable), with the same bounds. Its state is
+// the next configuration to be tried, its size, and the best divisor found so far. So both functions find
+// the same divisor, and the number of leaves is the same as __search_leaves.
+//
+// This file defines the following:
+//
+//      * struct positive_rank_search
+//        Resumable version of find_positive_rank_divisor().
+//
+//      * struct gonality_search
+//        Resumable version of find_gonality().
+//
+//      * class interleaved_scheduler
+//        Runs a window of gonality searches in time slices of a fixed number of leaves, giving priority
+//        to the searches that have used the fewest leaves so far. Results are reported in input order.
+//
+
+#ifndef __RESUMABLE_SEARCH_H__
+#define __RESUMABLE_SEARCH_H__
+
+#include "graphs.h"
+#include "divisors.h"
+#include "search_ranges.h"
+#include "alloc_stats.h"
+#include <cassert>
+#include <climits>
+#include <vector>
+#include <string>
+#include <sstream>
+
+
+const int INTERLEAVE_WINDOW = 16;          // maximum number of graphs in flight in the interleaved scheduler
+const long long INTERLEAVE_SLICE = 4096;   // number of leaves per time slice
+
+enum search_status {
+	SEARCH_RUNNING = 0,   // not finished; call step() to continue
+	SEARCH_FOUND = 1,     // divisor contains a positive rank divisor (call step() to continue the search)
+	SEARCH_EXHAUSTED = 2  // all candidates have been tried
+};
+
+
+
+// Resumable search for a positive rank effective divisor of prescribed degree.
+//
+// Usage:
+//     positive_rank_search S;
+//     S.init(G.n, deg);
+//     while (S.step(G, 1000) == SEARCH_RUNNING) {
+//         // do something else in between
+//     }
+//
+// The graph is not stored in the search state, so the same graph must be passed to every call of step().
+struct positive_rank_search {
+	int n;
+	int degree;
+	int status;
+	long long leaves;         // number of candidates tried so far
+	std::vector<int> divisor; // next candidate to be tried (or the positive rank divisor, if status == SEARCH_FOUND)
+
+	positive_rank_search() : n(0), degree(0), status(SEARCH_EXHAUSTED), leaves(0) {}
+
+	void init(int _n, int _degree) {
+		assert(_n >= 1 && _n <= MAX_N && _degree >= 1);
+		n = _n;
+		degree = _degree;
+		status = SEARCH_RUNNING;
+		leaves = 0;
+		divisor.assign(n, 0);
+		divisor[0] = degree;
+	}
+
+	// Move on to the next candidate in decreasing lexicographic order. Returns false if there is none.
+	//
+	// The next candidate is obtained by removing a chip from the last vertex j < n - 1 that has any chips
+	// (but keeping at least one chip on v0), and moving all chips of the vertices after j to vertex j + 1.
+	// Since the vertices strictly between j and n - 1 have no chips, the latter are only the chips on n - 1.
+	bool advance() {
+		int j = n - 2;
+		while (j >= 0 && divisor[j] == 0) {
+			j--;
+		}
+		if (j < 0 || (j == 0 && divisor[0] == 1)) {
+			return false;
+		}
+		int moved = divisor[n - 1] + 1;
+		divisor[j]--;
+		divisor[n - 1] = 0;
+		divisor[j + 1] = moved;
+		return true;
+	}
+
+	// Try at most max_leaves candidates, and return the new status.
+	//
+	// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __tmp_divisor, __can_reach.
+	int step(const my_graph& G, long long max_leaves) {
+		assert(G.n == n);
+		if (status == SEARCH_FOUND) {
+			status = (advance() ? SEARCH_RUNNING : SEARCH_EXHAUSTED);
+		}
+		for (long long i = 0; i < max_leaves && status == SEARCH_RUNNING; i++) {
+			leaves++;
+			// Same test as in find_positive_rank_divisor() (note that divisor[0] > 0 by construction).
+			if (burn(G, divisor.data(), 0) == 0 && has_positive_rank(G, divisor.data(), false)) {
+				status = SEARCH_FOUND;
+			}
+			else if (!advance()) {
+				status = SEARCH_EXHAUSTED;
+			}
+		}
+		return status;
+	}
+
+	// Write the state to a string, as "n degree status leaves k i_1 c_1 ... i_k c_k", where the last part
+	// lists the k vertices i_j with c_j > 0 chips in the next candidate.
+	std::string serialize() const {
+		std::ostringstream os;
+		int k = 0;
+		for (int i = 0; i < n; i++) {
+			k += (divisor[i] != 0);
+		}
+		os << n << ' ' << degree << ' ' << status << ' ' << leaves << ' ' << k;
+		for (int i = 0; i < n; i++) {
+			if (divisor[i] != 0) {
+				os << ' ' << i << ' ' << divisor[i];
+			}
+		}
+		return os.str();
+	}
+
+	// Read back a state written by serialize(). Returns false if the string is not a valid state.
+	bool deserialize(const std::string& s) {
+		std::istringstream is(s);
+		int k;
+		if (!(is >> n >> degree >> status >> leaves >> k) || n < 1 || n > MAX_N || degree < 1 || status < SEARCH_RUNNING || status > SEARCH_EXHAUSTED || k < 0 || k > n) {
+			return false;
+		}
+		divisor.assign(n, 0);
+		int deg = 0;
+		for (int j = 0; j < k; j++) {
+			int i, c;
+			if (!(is >> i >> c) || i < 0 || i >= n || c <= 0 || c > degree) {
+				return false;
+			}
+			divisor[i] = c;
+			deg += c;
+		}
+		return deg == degree && divisor[0] > 0;
+	}
+};
+
+
+
+// Resumable version of find_gonality(): the one-pass search over the superstable configurations (see
+// divisors.h), as a state machine.
+//
+// Usage:
+//     gonality_search S;
+//     S.init(G);
+//     while (!S.step(G, 1000)) {
+//         // do something else in between
+//     }
+//
+// The graph is not stored in the search state, so the same graph must be passed to every call of step().
+struct gonality_search {
+	int n;
+	int degree;                      // the gonality, once finished
+	int status;                      // SEARCH_RUNNING, or SEARCH_FOUND once finished
+	int size;                        // size of the configuration to be tried next
+	int best;                        // degree of the best divisor found so far (n + 1 if none)
+	long long leaves;                // number of configurations tried so far
+	long long failed_search_leaves;  // once finished: candidates of the (unsuccessful) brute force search at degree - 1 (see below)
+	std::vector<int> config;         // configuration to be tried next (on the vertices 1, ..., n - 1; config[0] = 0)
+	std::vector<int> divisor;        // best divisor found so far (the optimal divisor, once finished)
+
+	gonality_search() : n(0), degree(0), status(SEARCH_EXHAUSTED), size(0), best(0), leaves(0), failed_search_leaves(0) {}
+
+	void init(const my_graph& G) {
+		assert(G.is_valid_undirected_graph());
+		n = G.n;
+		degree = 0;
+		status = SEARCH_RUNNING;
+		size = 0;
+		best = n + 1;
+		leaves = 0;
+		failed_search_leaves = 0;
+		config.assign(n, 0); // the only configuration of size 0
+		divisor.assign(n, 1);
+	}
+
+	bool finished() const {
+		return status == SEARCH_FOUND;
+	}
+
+	// Continue the enumeration of __one_pass_level() at vertex v, where rem chips are left for the vertices
+	// v, ..., n - 1, and the extensions of the current value config[v] have all been tried (the entries after
+	// v are 0). Stores the next configuration of the current size in config, and returns false if there is none.
+	//
+	// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set.
+	bool advance(const my_graph& G, int v, int rem) {
+		while (v >= 1) {
+			if (config[v] == 0) {
+				// All values on v have been tried; continue with the next value on v - 1.
+				v--;
+				rem += (v >= 1 ? config[v] : 0);
+				continue;
+			}
+			config[v]--;
+			if (config[v] > 0 && burn(G, config.data(), 0) != 0) {
+				continue; // not superstable, and neither is any extension
+			}
+			if (config[v] == rem) {
+				return true;
+			}
+			if (v + 1 < n) {
+				// First value on v + 1 (this is decremented to rem - config[v] in the next iteration).
+				rem -= config[v];
+				v++;
+				config[v] = rem + 1;
+			}
+		}
+		return false;
+	}
+
+	// Move on to the next configuration: the next one of the current size, or the first one of the next size
+	// for which a better divisor can exist. Returns false if there is none.
+	//
+	// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set.
+	bool next(const my_graph& G) {
+		int last = n - 1;
+		while (last >= 1 && config[last] == 0) {
+			last--;
+		}
+		if (last >= 1 && advance(G, last, config[last])) {
+			return true;
+		}
+		while (size + 2 < best) {
+			size++;
+			config.assign(n, 0);
+			if (n >= 2) {
+				config[1] = size + 1;
+				if (advance(G, 1, size)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Try at most max_leaves configurations; returns true once the gonality has been found. The gonality is
+	// then stored in degree, and the corresponding divisor in divisor.
+	//
+	// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __partial_divisor, __tmp_divisor, __can_reach.
+	bool step(const my_graph& G, long long max_leaves) {
+		assert(G.n == n);
+		for (long long i = 0; i < max_leaves && status == SEARCH_RUNNING; i++) {
+			// Same test as in __one_pass_level().
+			leaves++;
+			for (int j = 0; j < n; j++) {
+				__partial_divisor[j] = config[j];
+			}
+			const int c = __min_chips_on_v0(G, best - size - 1);
+			if (c != -1) {
+				best = size + c;
+				divisor = config;
+				divisor[0] = c;
+			}
+			if (best <= size + 1 || !next(G)) {
+				status = SEARCH_FOUND;
+			}
+		}
+		if (status == SEARCH_FOUND && degree == 0) {
+			// The one-pass search shows that there is no positive rank divisor of degree best - 1, so the brute
+			// force search at that degree (as summarised in gonality certificates) tries all candidates.
+			assert(best <= n);
+			degree = best;
+			failed_search_leaves = (degree == 1 ? 0 : (long long) count_search_leaves(n, degree - 1));
+			assert(degree == 1 || count_search_leaves(n, degree - 1) <= (unsigned long long) LLONG_MAX);
+		}
+		return finished();
+	}
+
+	// Write the state to a string, as "n status size best leaves config_1 ... config_{n-1} divisor_0 ...
+	// divisor_{n-1}". Finished searches cannot be written.
+	std::string serialize() const {
+		assert(status == SEARCH_RUNNING);
+		std::ostringstream os;
+		os << n << ' ' << status << ' ' << size << ' ' << best << ' ' << leaves;
+		for (int i = 1; i < n; i++) {
+			os << ' ' << config[i];
+		}
+		for (int i = 0; i < n; i++) {
+			os << ' ' << divisor[i];
+		}
+		return os.str();
+	}
+
+	// Read back a state written by serialize(). Returns false if the string is not a valid state.
+	bool deserialize(const std::string& s) {
+		std::istringstream is(s);
+		if (!(is >> n >> status >> size >> best >> leaves) || n < 1 || n > MAX_N || status != SEARCH_RUNNING || size < 0 || best < 1 || best > n + 1 || size + 1 >= best || leaves < 0) {
+			return false;
+		}
+		degree = 0;
+		failed_search_leaves = 0;
+		config.assign(n, 0);
+		int total = 0;
+		for (int i = 1; i < n; i++) {
+			if (!(is >> config[i]) || config[i] < 0) {
+				return false;
+			}
+			total += config[i];
+		}
+		divisor.resize(n);
+		int deg = 0;
+		for (int i = 0; i < n; i++) {
+			if (!(is >> divisor[i]) || divisor[i] < 0) {
+				return false;
+			}
+			deg += divisor[i];
+		}
+		return total == size && (best == n + 1 || deg == best);
+	}
+};
+
+
+
+// Interleaved scheduler.
+//
+// Graphs are added one by one with add(). Up to INTERLEAVE_WINDOW graphs are kept in flight; whenever the
+// window is full, the scheduler runs time slices of INTERLEAVE_SLICE leaves, each time picking the unfinished
+// search that has used the fewest leaves so far (so that easy graphs are not held up by hard ones), until a
+// slot becomes available. The function passed to the constructor is called for every finished graph, in the
+// order in which the graphs were added. Call finish() after the last graph to process the remaining ones.
+class interleaved_scheduler {
+	struct slot {
+		my_graph G;
+		gonality_search S;
+	};
+	slot slots[INTERLEAVE_WINDOW];
+	int first, count;  // the graphs in flight are slots[first], ..., slots[first + count - 1] (cyclically)
+	void (*done)(const my_graph&, const gonality_search&);
+
+	// Report all finished graphs at the front of the window.
+	void report() {
+		while (count > 0 && slots[first].S.finished()) {
+			done(slots[first].G, slots[first].S);
+			first = (first + 1) % INTERLEAVE_WINDOW;
+			count--;
+		}
+	}
+
+	// Run one time slice for the unfinished search with the fewest leaves.
+	void run_slice() {
+		int best = -1;
+		for (int k = 0; k < count; k++) {
+			int i = (first + k) % INTERLEAVE_WINDOW;
+			if (!slots[i].S.finished() && (best == -1 || slots[i].S.leaves < slots[best].S.leaves)) {
+				best = i;
+			}
+		}
+		assert(best != -1);
+		slots[best].S.step(slots[best].G, INTERLEAVE_SLICE);
+		report();
+	}
+
+public:
+	interleaved_scheduler(void (*_done)(const my_graph&, const gonality_search&)) : first(0), count(0), done(_done) {}
+
+	void add(const my_graph& G) {
+		while (count == INTERLEAVE_WINDOW) {
+			run_slice();
+		}
+		ALLOC_PHASE("graph copy");
+		slot& s = slots[(first + count) % INTERLEAVE_WINDOW];
+		s.G.init();
+		s.G.setN(G.n);
+		for (int i = 0; i < G.n; i++) {
+			s.G.neighbours[i] = G.neighbours[i];
+		}
+		s.G.graph_name = G.graph_name;
+		s.S.init(s.G);
+		count++;
+	}
+
+	void finish() {
+		while (count > 0) {
+			run_slice();
+		}
+	}
+};
+
+
+#endif
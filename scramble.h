@@ -0,0 +1,349 @@
+// Scramble lower bounds for the gonality.
+//
+// A scramble on G is a collection of eggs: non-empty sets of vertices that induce connected subgraphs. The
+// order of a scramble is the minimum of
+//
+//      * its hitting number: the smallest size of a set of vertices that meets every egg;
+//      * its egg-cut number: the smallest number of edges whose removal separates two disjoint eggs (or
+//        infinity if no two eggs are disjoint).
+//
+// The gonality of G is at least the order of every scramble on G (Harp, Jackson, Jensen and Speeter), and
+// the scramble number (the largest order) is at least the treewidth. Here we only use scrambles whose eggs
+// are pairwise disjoint. Their hitting number is simply the number of eggs, and the egg-cut number is the
+// minimum over all pairs of eggs of the maximum number of edge-disjoint paths between them, so the order can
+// be computed (and checked) in polynomial time.
+//
+// Such a scramble on G also gives a scramble of (at least) the same order on every subdivision of G: add
+// the subdivision vertices of the edges inside every egg. The eggs stay disjoint and connected, and an edge
+// cut in the subdivision that separates two eggs gives an edge cut in G of at most the same size (take the
+// original edges of the cut edges).
+//
+// The search is a greedy heuristic. It starts with all single vertices as eggs, and repeatedly takes the
+// egg with the fewest edges leaving it, and merges it into the adjacent egg with the fewest edges leaving it
+// (a merged egg stays connected). The best scramble seen along the way is kept. The first run is
+// deterministic; further runs break ties randomly (with a fixed seed) and sometimes discard the egg instead
+// of merging it. They are repeated until the target order is reached, or for a fixed number of runs, so
+// the result does not depend on the speed of the machine. The target should be an upper bound for the
+// gonality (for instance the gonality itself, or gonality_upper_bound() below); otherwise all runs are
+// always used.
+//
+// This file defines the following:
+//
+//      * struct scramble
+//        A scramble with disjoint eggs, and its order.
+//
+//      * int scramble_order(const my_graph& G, const std::vector<std::vector<int> >& eggs)
+//        Order of a scramble with disjoint eggs (or -1 if the eggs are not valid).
+//
+//      * scramble find_scramble(const my_graph& G, int target, int runs)
+//        Heuristic search for a scramble of large order (see above).
+//
+//      * int gonality_upper_bound(const my_graph& G)
+//        A quick upper bound for the gonality (to be used as the target of find_scramble()).
+//
+
+#ifndef __SCRAMBLE_H__
+#define __SCRAMBLE_H__
+
+#include "graphs.h"
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <vector>
+
+
+const int SCRAMBLE_RUNS = 8; // default number of runs of find_scramble()
+
+
+struct scramble {
+	int order;
+	std::vector<std::vector<int> > eggs;
+};
+
+
+// Flow network for the egg cuts: every edge of G (parallel edges included, loops excluded) has capacity 1
+// in both directions.
+struct __egg_network {
+	int n;
+	std::vector<int> first;       // the arcs leaving v are first[v], ..., first[v + 1] - 1
+	std::vector<int> from, to, edge;
+	std::vector<int> sign;        // +1 if the arc goes from the first to the second endpoint of its edge, -1 otherwise
+	std::vector<int> flow;        // flow along every edge (from its first to its second endpoint)
+	std::vector<int> parent;      // arc along which a vertex was reached in the current search (-1: start, -2: not reached)
+	std::vector<int> queue;
+
+	void init(const my_graph& G) {
+		n = G.n;
+		first.assign(n + 1, 0);
+		for (int v = 0; v < n; v++) {
+			for (int w : G.neighbours[v]) {
+				if (w != v) {
+					first[v + 1]++;
+				}
+			}
+		}
+		for (int v = 0; v < n; v++) {
+			first[v + 1] += first[v];
+		}
+		const int arcs = first[n];
+		from.resize(arcs);
+		to.resize(arcs);
+		edge.resize(arcs);
+		sign.resize(arcs);
+		flow.assign(arcs / 2, 0);
+		parent.resize(n);
+		queue.resize(n);
+		std::vector<int> next(first.begin(), first.end() - 1);
+		int e = 0;
+		for (int v = 0; v < n; v++) {
+			for (int w : G.neighbours[v]) {
+				if (v < w) {
+					const int r = next[v]++, s = next[w]++;
+					from[r] = v; to[r] = w; edge[r] = e; sign[r] = 1;
+					from[s] = w; to[s] = v; edge[s] = e; sign[s] = -1;
+					e++;
+				}
+			}
+		}
+	}
+
+	// Maximum number of edge-disjoint paths from the vertices with label a to the vertices with label b
+	// (or limit, if this is smaller).
+	int max_flow(const std::vector<int>& label, const int a, const int b, const int limit) {
+		std::fill(flow.begin(), flow.end(), 0);
+		int ret = 0;
+		while (ret < limit) {
+			int head = 0, tail = 0;
+			for (int v = 0; v < n; v++) {
+				parent[v] = (label[v] == a ? -1 : -2);
+				if (label[v] == a) {
+					queue[tail++] = v;
+				}
+			}
+			int reached = -1;
+			while (head < tail && reached == -1) {
+				const int v = queue[head++];
+				for (int r = first[v]; r < first[v + 1]; r++) {
+					const int w = to[r];
+					if (parent[w] != -2 || sign[r] * flow[edge[r]] >= 1) {
+						continue;
+					}
+					parent[w] = r;
+					if (label[w] == b) {
+						reached = w;
+						break;
+					}
+					queue[tail++] = w;
+				}
+			}
+			if (reached == -1) {
+				break;
+			}
+			for (int w = reached; parent[w] != -1; w = from[parent[w]]) {
+				flow[edge[parent[w]]] += sign[parent[w]];
+			}
+			ret++;
+		}
+		return ret;
+	}
+};
+
+
+// Test whether the egg-cut number of the scramble given by the labels (egg number for every vertex, or -1)
+// is at least t. The eggs are given in order of increasing number of leaving edges, so that small cuts are
+// found early.
+bool __egg_cut_at_least(__egg_network& net, const std::vector<int>& label, const std::vector<int>& eggs, const int t) {
+	for (size_t i = 0; i < eggs.size(); i++) {
+		for (size_t j = 0; j < i; j++) {
+			if (net.max_flow(label, eggs[j], eggs[i], t) < t) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+// Order of a scramble with disjoint eggs (see above). Returns -1 if an egg is empty or disconnected, if two
+// eggs overlap, or if a vertex is out of range.
+int scramble_order(const my_graph& G, const std::vector<std::vector<int> >& eggs) {
+	std::vector<int> label(G.n, -1);
+	std::vector<int> stack;
+	for (size_t i = 0; i < eggs.size(); i++) {
+		if (eggs[i].empty()) {
+			return -1;
+		}
+		for (int v : eggs[i]) {
+			if (v < 0 || v >= G.n || label[v] != -1) {
+				return -1;
+			}
+			label[v] = i;
+		}
+		// Connectivity: search from the first vertex within the egg (visited vertices get label -2 - i).
+		int visited = 1;
+		stack.assign(1, eggs[i][0]);
+		label[eggs[i][0]] = -2 - (int) i;
+		while (!stack.empty()) {
+			const int v = stack.back();
+			stack.pop_back();
+			for (int w : G.neighbours[v]) {
+				if (label[w] == (int) i) {
+					label[w] = -2 - (int) i;
+					stack.push_back(w);
+					visited++;
+				}
+			}
+		}
+		if (visited != (int) eggs[i].size()) {
+			return -1;
+		}
+		for (int v : eggs[i]) {
+			label[v] = i;
+		}
+	}
+	const int k = eggs.size();
+	__egg_network net;
+	net.init(G);
+	int ret = k;
+	for (int i = 0; i < k; i++) {
+		for (int j = 0; j < i; j++) {
+			ret = net.max_flow(label, j, i, ret);
+		}
+	}
+	return ret;
+}
+
+
+// Heuristic search for a scramble of order at least target (see above). Stops as soon as such a scramble is
+// found, or after the given number of runs, and returns the best scramble found. For graphs with at least
+// one vertex, the result has order at least 1.
+scramble find_scramble(const my_graph& G, const int target, const int runs = SCRAMBLE_RUNS) {
+	scramble best;
+	best.order = 0;
+	if (G.n == 0) {
+		return best;
+	}
+	best.order = 1;
+	best.eggs.assign(1, std::vector<int>(1, 0));
+	__egg_network net;
+	net.init(G);
+	std::mt19937 rng(G.n);
+	std::vector<int> label(G.n), boundary(G.n), eggs, candidates;
+	for (int run = 0; run < runs && best.order < target; run++) {
+		const bool randomised = (run > 0);
+		for (int v = 0; v < G.n; v++) {
+			label[v] = v;
+		}
+		int k = G.n;
+		while (k > best.order && best.order < target) {
+			// Eggs in order of increasing number of leaving edges.
+			std::fill(boundary.begin(), boundary.end(), 0);
+			for (int v = 0; v < G.n; v++) {
+				for (int w : G.neighbours[v]) {
+					if (label[v] != -1 && label[w] != label[v]) {
+						boundary[label[v]]++;
+					}
+				}
+			}
+			eggs.clear();
+			for (int v = 0; v < G.n; v++) {
+				if (label[v] == v) {
+					eggs.push_back(v);
+				}
+			}
+			std::stable_sort(eggs.begin(), eggs.end(), [&boundary](int a, int b) { return boundary[a] < boundary[b]; });
+
+			// Is this scramble better than the best one so far?
+			int order = best.order;
+			while (order < k && __egg_cut_at_least(net, label, eggs, order + 1)) {
+				order++;
+			}
+			if (order > best.order) {
+				best.order = order;
+				best.eggs.assign(k, std::vector<int>());
+				for (int v = 0; v < G.n; v++) {
+					if (label[v] != -1) {
+						const int i = std::find(eggs.begin(), eggs.end(), label[v]) - eggs.begin();
+						best.eggs[i].push_back(v);
+					}
+				}
+			}
+
+			// Merge (or discard) an egg with the fewest leaving edges.
+			candidates.clear();
+			for (int a : eggs) {
+				if (boundary[a] == boundary[eggs[0]]) {
+					candidates.push_back(a);
+				}
+			}
+			const int a = candidates[randomised ? rng() % candidates.size() : 0];
+			candidates.clear();
+			for (int v = 0; v < G.n; v++) {
+				if (label[v] != a) {
+					continue;
+				}
+				for (int w : G.neighbours[v]) {
+					const int b = label[w];
+					if (b != -1 && b != a && (candidates.empty() || boundary[b] <= boundary[candidates[0]])) {
+						if (!candidates.empty() && boundary[b] < boundary[candidates[0]]) {
+							candidates.clear();
+						}
+						candidates.push_back(b);
+					}
+				}
+			}
+			int b = -1;
+			if (!candidates.empty() && !(randomised && rng() % 4 == 0)) {
+				b = candidates[randomised ? rng() % candidates.size() : 0];
+			}
+			for (int v = 0; v < G.n; v++) {
+				if (label[v] == a) {
+					label[v] = b;
+				}
+			}
+			if (b != -1 && b > a) {
+				// Keep the smallest vertex of every egg as its number.
+				for (int v = 0; v < G.n; v++) {
+					if (label[v] == b) {
+						label[v] = a;
+					}
+				}
+			}
+			k--;
+		}
+		if (G.n == 1) {
+			break;
+		}
+	}
+	return best;
+}
+
+
+// A quick upper bound for the gonality of G. If G is simple, then every independent set I gives a positive
+// rank divisor of degree n - |I| (see approximate_independent_sets.h); here I is chosen greedily (by minimum
+// degree). Otherwise, the bound is n.
+int gonality_upper_bound(const my_graph& G) {
+	if (!G.is_valid_undirected_graph(true)) {
+		return G.n;
+	}
+	std::vector<int> order(G.n);
+	for (int v = 0; v < G.n; v++) {
+		order[v] = v;
+	}
+	std::stable_sort(order.begin(), order.end(), [&G](int a, int b) { return G.neighbours[a].size() < G.neighbours[b].size(); });
+	std::vector<bool> blocked(G.n, false);
+	int independent = 0;
+	for (int v : order) {
+		if (!blocked[v]) {
+			independent++;
+			blocked[v] = true;
+			for (int w : G.neighbours[v]) {
+				blocked[w] = true;
+			}
+		}
+	}
+	return std::max(1, G.n - independent);
+}
+
+
+#endif
@@ -0,0 +1,214 @@
+// Exact counting, ranking and unranking of the search space of find_positive_rank_divisor(), and searches
+// over ranges of this space.
+//
+// find_positive_rank_divisor(G, d) tries the effective divisors of degree d with at least one chip on
+// vertex 0 in a fixed order: decreasingly by the number of chips on vertex 0, then on vertex 1, and so on
+// (i.e. in reverse lexicographic order). The number of these divisors that extend a given prefix (the chips
+// on the vertices 0, ..., k - 1) only depends on the number of remaining chips and vertices, so it is a
+// binomial coefficient. This makes it possible to compute the index of a divisor in the search order (rank),
+// and the divisor with a given index (unrank), in O(n d) steps.
+//
+// So the search at a given degree can be divided into index ranges [first, last) of equal size, which can be
+// handed to threads, processes or job files, and searched independently with
+// find_positive_rank_divisor_in_range(). Almost all divisors are rejected by a single burn (most of them are
+// not v0-reduced), so ranges of equal size take roughly equal time, and the progress within a range is
+// known exactly (__search_leaves out of last - first). Searching the ranges [0, i_1), [i_1, i_2), ... in
+// turn finds the same divisor as find_positive_rank_divisor().
+//
+// (The v0-reduced divisors themselves cannot be counted per prefix in this way. A v0-reduced divisor of degree
+// d is a superstable configuration on the vertices other than v0, of degree at most d, with the remaining
+// chips on v0; and the superstables are in bijection with the spanning trees. But there is no known way to
+// count the superstables under a prefix without enumerating them. This is why the ranges are taken over all
+// candidates instead.)
+//
+// find_gonality -d deg -r part/parts searches one of these ranges for every input graph (see find_gonality.cpp).
+//
+// All counts are exact as long as they fit in an unsigned long long; larger counts saturate at ULLONG_MAX.
+// Ranking and unranking require the total count count_search_leaves(n, d) to be smaller than ULLONG_MAX.
+//
+// This file defines the following functions:
+//
+//      * unsigned long long count_compositions(int vertices, int chips)
+//        Number of ways to distribute the given number of chips over the given number of vertices.
+//
+//      * unsigned long long count_search_leaves(int n, int deg)
+//        Number of divisors tried by find_positive_rank_divisor() (saturates at ULLONG_MAX).
+//
+//      * unsigned long long search_rank(int n, const int* divisor)
+//        Index of a divisor in the search order of find_positive_rank_divisor().
+//
+//      * void search_unrank(int n, int deg, unsigned long long index, int* divisor)
+//        The divisor with the given index in the search order.
+//
+//      * bool next_search_leaf(int n, int* divisor)
+//        Replace a divisor by the next one in the search order.
+//
+//      * void search_range_part(int n, int deg, int parts, int part, unsigned long long& first, unsigned long long& last)
+//        Divide the search into the given number of ranges of (almost) equal size.
+//
+//      * bool find_positive_rank_divisor_in_range(const my_graph& G, int deg, unsigned long long first, unsigned long long last)
+//        Search for a positive rank divisor among the divisors with index in [first, last).
+//
+
+#ifndef __SEARCH_RANGES_H__
+#define __SEARCH_RANGES_H__
+
+#include "graphs.h"
+#include "divisors.h"
+#include <cassert>
+#include <climits>
+
+
+// Number of ways to distribute the given number of chips over the given number of vertices, i.e. the
+// binomial coefficient C(chips + vertices - 1, vertices - 1). Returns ULLONG_MAX if the result does not fit.
+unsigned long long count_compositions(int vertices, int chips) {
+	assert(vertices >= 1 && chips >= 0);
+	const unsigned long long N = (unsigned long long) chips + vertices - 1;
+	unsigned long long k = chips;
+	if (k > N - k) {
+		k = N - k;
+	}
+	unsigned long long ret = 1;
+	for (unsigned long long i = 0; i < k; i++) {
+		// ret = C(N, i) here, and C(N, i + 1) = C(N, i) * (N - i) / (i + 1). Divide by the common factor
+		// of C(N, i) and i + 1 first, so that the result saturates only if C(N, i + 1) does not fit.
+		unsigned long long a = ret, b = i + 1;
+		while (b != 0) {
+			const unsigned long long t = a % b;
+			a = b;
+			b = t;
+		}
+		const unsigned long long factor = (N - i) / ((i + 1) / a);
+		if (ret / a > ULLONG_MAX / factor) {
+			return ULLONG_MAX;
+		}
+		ret = (ret / a) * factor;
+	}
+	return ret;
+}
+
+
+// Number of effective divisors of degree deg on n vertices with at least one chip on vertex 0, i.e. the
+// number of leaves visited by find_positive_rank_divisor(G, deg) if it does not find anything. This is the
+// binomial coefficient C(n + deg - 2, n - 1). Returns ULLONG_MAX if the result does not fit.
+unsigned long long count_search_leaves(int n, int deg) {
+	assert(n >= 1 && deg >= 1);
+	return count_compositions(n, deg - 1);
+}
+
+
+// Index of a divisor (with at least one chip on vertex 0) in the search order of find_positive_rank_divisor().
+unsigned long long search_rank(int n, const int* divisor) {
+	assert(n >= 1 && divisor[0] >= 1);
+	int remaining_chips = 0;
+	for (int i = 0; i < n; i++) {
+		assert(divisor[i] >= 0);
+		remaining_chips += divisor[i];
+	}
+	assert(count_search_leaves(n, remaining_chips) < ULLONG_MAX);
+	unsigned long long ret = 0;
+	for (int p = 0; p + 1 < n; p++) {
+		// The divisors that come first are the ones with more chips on p: for every such number of chips
+		// c, there are count_compositions(n - p - 1, remaining_chips - c) of them, and these add up to:
+		if (divisor[p] < remaining_chips) {
+			ret += count_compositions(n - p, remaining_chips - divisor[p] - 1);
+		}
+		remaining_chips -= divisor[p];
+	}
+	return ret;
+}
+
+
+// Store the divisor with the given index in the search order of find_positive_rank_divisor(G, deg) (for a
+// graph on n vertices) in the array given as the last argument.
+void search_unrank(int n, int deg, unsigned long long index, int* divisor) {
+	assert(n >= 1 && deg >= 1);
+	assert(index < count_search_leaves(n, deg) && count_search_leaves(n, deg) < ULLONG_MAX);
+	int remaining_chips = deg;
+	for (int p = 0; p + 1 < n; p++) {
+		int c = remaining_chips;
+		while (true) {
+			assert(c >= (p == 0 ? 1 : 0)); // at least one chip on v0
+			const unsigned long long count = count_compositions(n - p - 1, remaining_chips - c);
+			if (index < count) {
+				break;
+			}
+			index -= count;
+			c--;
+		}
+		divisor[p] = c;
+		remaining_chips -= c;
+	}
+	assert(index == 0 && (n > 1 || remaining_chips >= 1));
+	divisor[n - 1] = remaining_chips;
+}
+
+
+// Replace the divisor (with at least one chip on vertex 0) by the next one in the search order of
+// find_positive_rank_divisor(). Returns false if it was the last one (the divisor is unchanged then).
+bool next_search_leaf(int n, int* divisor) {
+	assert(n >= 1);
+	// Take one chip from the last vertex p < n - 1 that can give one away, and put all chips after p on p + 1.
+	int suffix = divisor[n - 1];
+	for (int p = n - 2; p >= 0; p--) {
+		if (divisor[p] > (p == 0 ? 1 : 0)) {
+			divisor[p]--;
+			divisor[p + 1] = suffix + 1;
+			for (int i = p + 2; i < n; i++) {
+				divisor[i] = 0;
+			}
+			return true;
+		}
+		suffix += divisor[p];
+	}
+	return false;
+}
+
+
+// Divide the search of find_positive_rank_divisor(G, deg) (for a graph on n vertices) into the given number of
+// consecutive ranges whose sizes differ by at most 1, and store the range with the given number (0, ..., parts - 1)
+// in first and last.
+void search_range_part(int n, int deg, int parts, int part, unsigned long long& first, unsigned long long& last) {
+	assert(parts >= 1 && part >= 0 && part < parts);
+	const unsigned long long total = count_search_leaves(n, deg);
+	assert(total < ULLONG_MAX);
+	const unsigned long long size = total / parts;
+	const unsigned long long extra = total % parts;
+	first = size * part + ((unsigned long long) part < extra ? part : extra);
+	last = first + size + ((unsigned long long) part < extra ? 1 : 0);
+}
+
+
+// Search for a positive rank effective divisor of the given degree among the divisors with index in
+// [first, last) in the search order of find_positive_rank_divisor().
+//
+// Output values:
+//     * the return value is a boolean indicating whether or not a positive rank divisor was found in the range;
+//     * in case of success, the first such divisor is stored in the global variable __partial_divisor;
+//     * the number of divisors that were tried is stored in __search_leaves.
+//
+// Changes global variables __pushed_to_queue, __burnt_edges, __firing_set, __partial_divisor, __tmp_divisor, __can_reach, __search_leaves.
+bool find_positive_rank_divisor_in_range(const my_graph& G, int deg, unsigned long long first, unsigned long long last) {
+	assert(G.is_valid_undirected_graph());
+	assert(first <= last && last <= count_search_leaves(G.n, deg));
+	__search_leaves = 0;
+	if (first == last) {
+		return false;
+	}
+	search_unrank(G.n, deg, first, __partial_divisor);
+	while (true) {
+		__search_leaves++;
+		if (burn(G, __partial_divisor, 0) == 0 && has_positive_rank(G, __partial_divisor, false)) {
+			return true;
+		}
+		if (first + __search_leaves == last) {
+			return false;
+		}
+		bool ok = next_search_leaf(G.n, __partial_divisor);
+		assert(ok);
+		(void) ok;
+	}
+}
+
+
+#endif
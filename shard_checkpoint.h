@@ -0,0 +1,147 @@
+// Checkpoints for long enumerations (used by Brill_Noether_geng -k).
+//
+// Geng cannot resume the generation of a res/mod shard halfway through, but generating the graphs is far
+// cheaper than checking them. So an interrupted shard can be resumed by generating all graphs again, and
+// skipping the checks for the graphs that were already done. A checkpoint records how many graphs were
+// done, together with a fingerprint (the graph6 string of the last of these graphs), which is compared with
+// the graph that geng generates at that position when resuming, so that a checkpoint is never applied to a
+// different enumeration by accident. It also records the running totals and a few statistics, so that the
+// final summary covers the whole shard.
+//
+// Checkpoints are small text files, one "key value" pair per line. They are written to a temporary file,
+// synced to disk, and then renamed, so that a crash while writing a checkpoint leaves the previous one
+// intact.
+//
+// Requires POSIX (open/fsync/rename).
+//
+// This file defines the following:
+//
+//      * struct shard_checkpoint
+//        The contents of a checkpoint, with the functions read() and write().
+//
+
+#ifndef __SHARD_CHECKPOINT_H__
+#define __SHARD_CHECKPOINT_H__
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+const char SHARD_CHECKPOINT_MAGIC[] = "dgon-checkpoint";
+const int SHARD_CHECKPOINT_VERSION = 1;
+const int SHARD_CHECKPOINT_STAGES = 5;     // number of stages in the statistics (cf. results_db_stage)
+const time_t SHARD_CHECKPOINT_SECONDS = 60; // time between two periodic checkpoints
+
+
+struct shard_checkpoint {
+	int n, res, mod;                              // the enumeration
+	long long graphs;                             // number of graphs that were done
+	long long problems;                           // number of problems found among these graphs
+	std::string fingerprint;                      // graph6 string of graph number "graphs" (empty if graphs == 0)
+	long long records;                            // number of records in the results file (-1 if there is none)
+	long long stages[SHARD_CHECKPOINT_STAGES];    // number of graphs per stage (see results_db_stage)
+	long long seconds;                            // total running time (over all runs)
+
+	shard_checkpoint() : n(0), res(0), mod(1), graphs(0), problems(0), records(-1), seconds(0) {
+		for (int i = 0; i < SHARD_CHECKPOINT_STAGES; i++) {
+			stages[i] = 0;
+		}
+	}
+
+	// Read a checkpoint. Returns false if the file does not exist; exits with an error if it is invalid.
+	bool read(const std::string& path) {
+		std::ifstream in(path.c_str());
+		if (!in) {
+			return false;
+		}
+		std::string key, magic;
+		int version = -1;
+		bool ok = bool(in >> magic >> version) && magic == SHARD_CHECKPOINT_MAGIC && version == SHARD_CHECKPOINT_VERSION;
+		int seen = 0;
+		while (ok && in >> key) {
+			if (key == "n") {
+				ok = bool(in >> n);
+			}
+			else if (key == "res") {
+				ok = bool(in >> res);
+			}
+			else if (key == "mod") {
+				ok = bool(in >> mod);
+			}
+			else if (key == "graphs") {
+				ok = bool(in >> graphs);
+			}
+			else if (key == "problems") {
+				ok = bool(in >> problems);
+			}
+			else if (key == "fingerprint") {
+				ok = bool(in >> fingerprint);
+			}
+			else if (key == "records") {
+				ok = bool(in >> records);
+			}
+			else if (key == "stages") {
+				for (int i = 0; ok && i < SHARD_CHECKPOINT_STAGES; i++) {
+					ok = bool(in >> stages[i]);
+				}
+			}
+			else if (key == "seconds") {
+				ok = bool(in >> seconds);
+			}
+			else {
+				ok = false;
+			}
+			seen++;
+		}
+		if (!ok || seen != 9 || graphs < 0 || problems < 0 || records < -1 || (graphs > 0) != (fingerprint != "-")) {
+			fprintf(stderr, ">E Error: invalid checkpoint file \"%s\".\n", path.c_str());
+			exit(1);
+		}
+		if (fingerprint == "-") {
+			fingerprint.clear();
+		}
+		return true;
+	}
+
+	// Write the checkpoint (atomically). Exits with an error if this fails.
+	void write(const std::string& path) const {
+		std::ostringstream out;
+		out << SHARD_CHECKPOINT_MAGIC << ' ' << SHARD_CHECKPOINT_VERSION << '\n';
+		out << "n " << n << '\n';
+		out << "res " << res << '\n';
+		out << "mod " << mod << '\n';
+		out << "graphs " << graphs << '\n';
+		out << "problems " << problems << '\n';
+		out << "fingerprint " << (fingerprint.empty() ? "-" : fingerprint) << '\n';
+		out << "records " << records << '\n';
+		out << "stages";
+		for (int i = 0; i < SHARD_CHECKPOINT_STAGES; i++) {
+			out << ' ' << stages[i];
+		}
+		out << '\n';
+		out << "seconds " << seconds << '\n';
+		const std::string data = out.str();
+		const std::string tmp_path = path + ".tmp";
+		int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		bool ok = (fd != -1);
+		if (ok) {
+			ok = (::write(fd, data.data(), data.size()) == (ssize_t) data.size()) && fsync(fd) == 0;
+			ok = (close(fd) == 0) && ok;
+		}
+		if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+			perror("checkpoint");
+			fprintf(stderr, ">E Error: failed to write checkpoint file \"%s\".\n", path.c_str());
+			exit(1);
+		}
+	}
+};
+
+
+#endif
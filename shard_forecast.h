@@ -0,0 +1,273 @@
+// Runtime forecasts for long enumerations (used by Brill_Noether_geng -F).
+//
+// The res/mod shards of an enumeration differ a lot in cost, so the running time of a complete enumeration
+// cannot be guessed from a single shard. A forecast runs a random sample of k out of mod (fine-grained)
+// shards, one at a time, and records for every shard, per number of edges and per stage (see
+// results_db_stage), the number of graphs and the time spent checking them, as well as the total running
+// time of the shard (which also includes the generation of the graphs by geng).
+//
+// The sample is a simple random sample (without replacement) of the mod shards, so the total of any of
+// these quantities over all shards is estimated by mod * mean, with standard error
+//
+//      mod * s / sqrt(k) * sqrt(1 - k / mod),
+//
+// where s is the standard deviation of the quantity over the sampled shards. The confidence intervals use
+// Student's t distribution with k - 1 degrees of freedom. The shard costs are skewed, so the intervals are
+// only reliable for samples that are not too small (say at least 30 shards); the report also shows the
+// most expensive shard of the sample. The lower end of an interval is never below the total over the
+// sampled shards, which is a hard lower bound.
+//
+// The report groups the edge counts by their Brill–Noether bound (two consecutive edge counts have the same
+// bound), and recommends a number of shards for a few target running times per shard. The recommendation
+// assumes that a shard of a coarser enumeration (mod' shards) costs as much as r = mod / mod' independent
+// fine shards: on average r * mu, with standard deviation sqrt(r) * sigma (where mu and sigma are the mean and
+// standard deviation of the fine shards). The recommended mod' is the smallest one for which
+// r * mu + z * sqrt(r) * sigma is at most the target, with z = 1.645, so that about 95% of the shards finish
+// in time. Recommendations with mod' > mod extrapolate below the sampled granularity.
+//
+// This file defines the following:
+//
+//      * struct shard_sample
+//        Instrumentation of a single shard.
+//
+//      * std::vector<int> choose_forecast_shards(int n, int k, int mod)
+//        A (reproducible) random sample of k out of mod shards.
+//
+//      * void print_shard_forecast(std::ostream& os, int n, int mod, const std::vector<shard_sample>& samples, int max_mod)
+//        Print the forecast for an enumeration, based on the given samples (see above).
+//
+
+#ifndef __SHARD_FORECAST_H__
+#define __SHARD_FORECAST_H__
+
+#include "results_db.h"
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include <ostream>
+
+
+const int SHARD_FORECAST_MAX_EDGES = 256;            // maximum number of edges of the graphs in a forecast
+const int SHARD_FORECAST_STAGES = STAGE_BRUTE_FORCE + 1; // number of stages in the statistics (see results_db_stage)
+const double SHARD_FORECAST_Z = 1.645;                // one-sided 95% quantile of the normal distribution (for the recommendations)
+const double SHARD_FORECAST_TARGETS[] = {600, 3600, 86400}; // target running times per shard for the recommendations (in seconds)
+
+
+struct shard_sample {
+	int res;                                                                   // the shard
+	double seconds;                                                            // total running time of the shard
+	long long problems;                                                        // number of graphs that fail the Brill–Noether bound
+	long long graphs[SHARD_FORECAST_MAX_EDGES][SHARD_FORECAST_STAGES];        // number of graphs per number of edges and stage
+	double check_seconds[SHARD_FORECAST_MAX_EDGES][SHARD_FORECAST_STAGES];    // time spent checking these graphs
+
+	void clear(int shard) {
+		res = shard;
+		seconds = 0;
+		problems = 0;
+		for (int m = 0; m < SHARD_FORECAST_MAX_EDGES; m++) {
+			for (int s = 0; s < SHARD_FORECAST_STAGES; s++) {
+				graphs[m][s] = 0;
+				check_seconds[m][s] = 0;
+			}
+		}
+	}
+
+	// Record a graph with m edges that was settled in the given stage in the given time.
+	void add(long long m, int stage, double t) {
+		assert(m >= 0 && m < SHARD_FORECAST_MAX_EDGES && stage >= 0 && stage < SHARD_FORECAST_STAGES);
+		graphs[m][stage]++;
+		check_seconds[m][stage] += t;
+	}
+};
+
+
+// A random sample of k out of the shards 0, ..., mod - 1 (in increasing order). The sample only depends on
+// n, k and mod, so that a forecast can be repeated.
+std::vector<int> choose_forecast_shards(int n, int k, int mod) {
+	assert(k >= 1 && k <= mod);
+	std::mt19937 rng(n * 1000003u + mod);
+	std::vector<int> all(mod);
+	std::iota(all.begin(), all.end(), 0);
+	for (int i = 0; i < k; i++) {
+		std::swap(all[i], all[i + rng() % (mod - i)]);
+	}
+	std::vector<int> ret(all.begin(), all.begin() + k);
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+
+// Two-sided 95% quantile of Student's t distribution with the given number of degrees of freedom.
+double __student_t_95(int df) {
+	static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+			2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+			2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+	assert(df >= 1);
+	if (df <= 30) {
+		return table[df - 1];
+	}
+	return (df <= 60 ? 2.000 : (df <= 120 ? 1.980 : 1.960));
+}
+
+// Estimate of the total of a quantity over all mod shards, given its values on the sampled shards, with a 95%
+// confidence interval [low, high] (see above).
+double __estimate_total(const std::vector<double>& values, int mod, double& low, double& high) {
+	const int k = values.size();
+	assert(k >= 1 && k <= mod);
+	double sum = 0;
+	for (double x : values) {
+		sum += x;
+	}
+	const double mean = sum / k;
+	const double estimate = mod * mean;
+	if (k == 1) {
+		low = sum;
+		high = INFINITY;
+		return estimate;
+	}
+	double squares = 0;
+	for (double x : values) {
+		squares += (x - mean) * (x - mean);
+	}
+	const double s = sqrt(squares / (k - 1));
+	const double error = __student_t_95(k - 1) * mod * s / sqrt((double) k) * sqrt(1.0 - (double) k / mod);
+	low = std::max(estimate - error, sum);
+	high = estimate + error;
+	return estimate;
+}
+
+std::string __format_seconds(double t) {
+	char tmp[50];
+	if (std::isinf(t)) {
+		return "?";
+	}
+	if (t < 100) {
+		sprintf(tmp, "%.2f s", t);
+	}
+	else if (t < 100 * 60) {
+		sprintf(tmp, "%.1f min", t / 60);
+	}
+	else if (t < 100 * 3600) {
+		sprintf(tmp, "%.1f h", t / 3600);
+	}
+	else {
+		sprintf(tmp, "%.1f d", t / 86400);
+	}
+	return tmp;
+}
+
+std::string __format_interval(double low, double high) {
+	return "[" + __format_seconds(low) + ", " + __format_seconds(high) + "]";
+}
+
+
+// Print the forecast for the enumeration of the graphs on n vertices in mod shards, based on the given
+// samples (see above). The recommended numbers of shards are at most max_mod.
+void print_shard_forecast(std::ostream& os, int n, int mod, const std::vector<shard_sample>& samples, int max_mod) {
+	assert(!samples.empty());
+	const int k = samples.size();
+	char line[300];
+	long long problems = 0;
+	for (const shard_sample& S : samples) {
+		problems += S.problems;
+	}
+	os << "Forecast for n = " << n << ", based on " << k << " of " << mod << " shards (" << problems << " problems found in the sample):" << std::endl;
+	os << std::endl;
+	sprintf(line, "%9s %4s %14s %8s %8s %8s %8s %14s %10s %10s  %s",
+			"edges", "BN", "graphs", "leaf", "trivial", "indep.", "brute", "brute force", "us/graph", "time", "95% interval");
+	os << line << std::endl;
+
+	// One row per Brill–Noether bound b, i.e. per range of edge counts m with (m - n + 4) / 2 = b.
+	std::vector<double> values(k), check_total(k, 0);
+	double low, high;
+	for (int first = 0; first < SHARD_FORECAST_MAX_EDGES; ) {
+		const int b = (first - n + 4 >= 0 ? (first - n + 4) / 2 : -1);
+		int last = first;
+		while (last + 1 < SHARD_FORECAST_MAX_EDGES && (last + 1 - n + 4 >= 0 ? (last + 1 - n + 4) / 2 : -1) == b) {
+			last++;
+		}
+		long long stage_graphs[SHARD_FORECAST_STAGES] = {0};
+		long long graphs = 0;
+		double seconds = 0;
+		for (int i = 0; i < k; i++) {
+			values[i] = 0;
+			for (int m = first; m <= last; m++) {
+				for (int s = 0; s < SHARD_FORECAST_STAGES; s++) {
+					stage_graphs[s] += samples[i].graphs[m][s];
+					graphs += samples[i].graphs[m][s];
+					values[i] += samples[i].check_seconds[m][s];
+				}
+			}
+			seconds += values[i];
+			check_total[i] += values[i];
+		}
+		if (graphs > 0) {
+			const double time = __estimate_total(values, mod, low, high);
+			sprintf(line, "%4d-%-4d %4d %14.0f %7.2f%% %7.2f%% %7.2f%% %7.2f%% %14.0f %10.2f %10s  %s",
+					first, last, b, (double) graphs * mod / k,
+					100.0 * stage_graphs[STAGE_LEAF] / graphs, 100.0 * stage_graphs[STAGE_TRIVIAL_BOUND] / graphs,
+					100.0 * stage_graphs[STAGE_INDEPENDENT_SET] / graphs, 100.0 * stage_graphs[STAGE_BRUTE_FORCE] / graphs,
+					(double) stage_graphs[STAGE_BRUTE_FORCE] * mod / k, 1e6 * seconds / graphs,
+					__format_seconds(time).c_str(), __format_interval(low, high).c_str());
+			os << line << std::endl;
+		}
+		first = last + 1;
+	}
+
+	// Totals, and the time spent outside the checks (mostly generating the graphs).
+	const double checks = __estimate_total(check_total, mod, low, high);
+	os << std::endl;
+	os << "Checking the graphs:   " << __format_seconds(checks) << " (95% interval: " << __format_interval(low, high) << ")" << std::endl;
+	for (int i = 0; i < k; i++) {
+		values[i] = std::max(samples[i].seconds - check_total[i], 0.0);
+	}
+	const double generation = __estimate_total(values, mod, low, high);
+	os << "Generation and other:  " << __format_seconds(generation) << " (95% interval: " << __format_interval(low, high) << ")" << std::endl;
+	int largest = 0;
+	for (int i = 0; i < k; i++) {
+		values[i] = samples[i].seconds;
+		if (values[i] > values[largest]) {
+			largest = i;
+		}
+	}
+	const double total = __estimate_total(values, mod, low, high);
+	sprintf(line, "%.2f", total / 86400);
+	os << "Total running time:    " << __format_seconds(total) << " (95% interval: " << __format_interval(low, high) << "), i.e. "
+			<< line << " core-days" << std::endl;
+
+	// Shard costs, and the recommended granularity.
+	const double mu = total / mod;
+	double sigma = 0;
+	for (int i = 0; i < k; i++) {
+		sigma += (values[i] - mu) * (values[i] - mu);
+	}
+	sigma = (k >= 2 ? sqrt(sigma / (k - 1)) : 0);
+	os << "Shards (" << mod << "): " << __format_seconds(mu) << " on average, standard deviation " << __format_seconds(sigma)
+			<< ", most expensive in the sample: " << __format_seconds(values[largest]) << " (shard " << samples[largest].res << "/" << mod << ")" << std::endl;
+	if (k == 1) {
+		os << "(Sample more than one shard for confidence intervals.)" << std::endl;
+	}
+	os << std::endl;
+	for (double target : SHARD_FORECAST_TARGETS) {
+		int recommended = 1;
+		if (mu > 0) {
+			// Largest r with r * mu + z * sqrt(r) * sigma <= target (a quadratic equation in sqrt(r)).
+			const double zs = SHARD_FORECAST_Z * sigma;
+			const double x = (-zs + sqrt(zs * zs + 4 * mu * target)) / (2 * mu);
+			const double r = x * x;
+			recommended = (int) std::min((double) max_mod, std::max(1.0, ceil(mod / r)));
+		}
+		const double r = (double) mod / recommended;
+		os << "For shards of at most " << __format_seconds(target) << ": mod = " << recommended << " (" << __format_seconds(r * mu)
+				<< " per shard on average, " << __format_seconds(r * mu + SHARD_FORECAST_Z * sqrt(r) * sigma) << " for 95% of the shards"
+				<< (recommended > mod ? "; finer than the sample, extrapolated" : "") << ")" << std::endl;
+	}
+}
+
+
+#endif
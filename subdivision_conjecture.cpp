@@ -2,7 +2,7 @@
 // Brill–Noether conjectures for these graphs.
 // 
 // Usage:
-//       ./subdivision_conjecture [-gfvv] [k] < infile.in
+//       ./subdivision_conjecture [-gpfvv] [-R threads] [-o file] [k] < infile.in
 // 
 //       Numerical argument k: number of parts into which every edge must be subdivided
 //                             before comparing the gonality of the subdivision to the
@@ -10,14 +10,27 @@
 // 
 //       Input options:
 //       -g  : use graph6 input instead of plain input
+//       -p  : pipelined I/O (read, solve and write on separate threads; see pipeline.h)
 // 
 //       Computational options:
 //       -f  : fast test routine (do not compute gonality of subdivision; only try
 //             to find a positive rank divisor of smaller degree) (about 20% faster)
+//  -R N     : use N threads for the positive rank test on graphs with at least PARALLEL_RANK_MIN_N
+//             vertices (see parallel_rank.h; default: the number of hardware threads; -R 1 disables
+//             the parallel test, e.g. when several processes share a machine)
+// 
+//       In both modes, graphs whose treewidth equals their gonality are settled without looking
+//       at the subdivision: gonality is bounded below by treewidth, and the subdivision has the
+//       same treewidth bound (see treewidth.h). The same holds for graphs with a scramble (with
+//       disjoint eggs) whose order equals their gonality, if one is found in SCRAMBLE_RUNS runs of
+//       the heuristic search (see scramble.h). The number of such graphs is shown in the summary.
 // 
 //       Output options:
 //       -v  : verbose (also print gonality of non-counterexamples)
 //       -vv : extra verbose (also print optimal divisor for non-counterexamples)
+//  -o file  : write the verdict for every graph to the binary results file "file" (see results_db.h;
+//             the file must not contain any results yet; its header identifies the input by k and
+//             the first graph)
 // 
 // 
 // By default, the input should use the following "plain" format:
@@ -32,10 +45,13 @@
 // 
 // Use the auxiliary programs convert_[to/from]_graph6 to convert between the plain format
 // and the graph6 format.
+// 
+// Input (in either format) may also be compressed with gzip or xz; this is detected automatically
+// (see compressed_input.h).
 
 
 #define USAGE_STRING \
-"subdivision_conjecture [-gfvv] [k] < infile.in"
+"subdivision_conjecture [-gpfvv] [-R threads] [-o file] [k] < infile.in"
 
 #define HELPTEXT \
 " Compares the gonality of every graph specified in the file \"infile.in\" to the\n\
@@ -47,14 +63,19 @@
 \n\
     Input options:\n\
        -g    : use graph6 input instead of plain input\n\
+       -p    : pipelined I/O (read, solve and write on separate threads)\n\
 \n\
     Computational options:\n\
        -f    : fast test routine (do not compute gonality of subdivision; only try\n\
                to find a positive rank divisor of smaller degree) (about 20% faster)\n\
+    -R N     : use N threads for the positive rank test on large graphs\n\
+               (default: all hardware threads; -R 1 disables the parallel test)\n\
 \n\
     Output options:\n\
        -v    : verbose (also print gonality of non-counterexamples)\n\
        -vv   : extra verbose (also print optimal divisor for non-counterexamples)\n\
+    -o file  : write the verdict for every graph to the binary results file \"file\"\n\
+               (which must not contain any results yet; use query_results to read it)\n\
 \n\
   See program text for much more information.\n"
 
@@ -72,6 +93,13 @@ const int MAX_PARTS_PER_EDGE = 10; // edges may be subdivided into at most 10 pa
 #include "graph6.h"
 #include "graph_io.h"
 #include "divisors.h"
+#include "parallel_rank.h"
+#include "pipeline.h"
+#include "results_db.h"
+#include "treewidth.h"
+#include "scramble.h"
+#include "compressed_input.h"
+#include "alloc_stats.h"
 #include <iostream>
 #include <string>
 #include <cassert>
@@ -87,6 +115,51 @@ int verbosity = 0;
 
 int count_graphs = 0;
 int count_probs = 0;
+int count_settled_by_treewidth = 0;
+int count_settled_by_scramble = 0;
+
+string results_path;
+results_db_writer results_db;
+
+// Test whether gon(H) >= gon(G) for every subdivision H of G, using the treewidth or a scramble on G.
+bool settled_without_subdivision(const my_graph& G, int gon_G) {
+	if (treewidth_at_least(G, gon_G)) {
+		count_settled_by_treewidth++;
+		return true;
+	}
+	if (find_scramble(G, gon_G).order >= gon_G) {
+		count_settled_by_scramble++;
+		return true;
+	}
+	return false;
+}
+
+// Description of the input for the header of the results file: the options that affect the results, and
+// the first graph.
+string input_description(const my_graph& G) {
+	string ret = "subdivision_conjecture " + to_string(arg_k) + (arg_f ? " -f " : " ") + to_string(G.n);
+	for (int i = 0; i < G.n; i++) {
+		for (int j : G.neighbours[i]) {
+			if (i < j) {
+				ret += ' ' + to_string(i) + '-' + to_string(j);
+			}
+		}
+	}
+	return ret;
+}
+
+// Append the verdict for the current graph to the results file (if requested). The file is opened when the
+// first graph is done, as its header identifies the input by the first graph.
+void record_result(const my_graph& G, int m, int gon_G, int Brill_Noether_bound, bool fails_Brill_Noether, bool fails_subdivision) {
+	if (results_path.empty()) {
+		return;
+	}
+	if (!results_db.is_open()) {
+		results_db.open(results_path, 0, 0, 1, results_db_input_id(input_description(G)), false);
+	}
+	const uint8_t flags = (fails_Brill_Noether ? RESULT_FAILS_BRILL_NOETHER : 0) | (fails_subdivision ? RESULT_FAILS_SUBDIVISION : 0);
+	results_db.append(count_graphs, G.n, m, STAGE_BRUTE_FORCE, gon_G, Brill_Noether_bound, flags);
+}
 
 // Extended graph test routine (also computes the gonality of the subdivision).
 void check_graph_extended(const my_graph& G) {
@@ -101,13 +174,25 @@ void check_graph_extended(const my_graph& G) {
 	// Compute gonality of original graph
 	const int gon_G = find_gonality(G);
 	
-	// Compute gonality of subdivided graph
+	// Compute gonality of subdivided graph. If tw(G) = gon(G) (or a scramble on G has order gon(G)), then
+	// gon(H) >= gon(G), and the divisor found on G also has positive rank on H, so gon(H) = gon(G).
 	my_graph H = subdivide(G, arg_k);
-	const int gon_H = find_gonality(H);
+	int gon_H;
+	if (settled_without_subdivision(G, gon_G)) {
+		gon_H = gon_G;
+		for (int i = G.n; i < H.n; i++) {
+			__partial_divisor[i] = 0;
+		}
+		assert(has_positive_rank(H, __partial_divisor));
+	}
+	else {
+		gon_H = find_gonality(H);
+	}
 	bool is_counterexample = gon_G != gon_H || gon_G > Brill_Noether_bound || gon_H > Brill_Noether_bound;
 	if (is_counterexample) {
 		count_probs++;
 	}
+	record_result(G, m, gon_G, Brill_Noether_bound, gon_G > Brill_Noether_bound || gon_H > Brill_Noether_bound, gon_G != gon_H);
 	
 	// Print output if necessary
 	if (is_counterexample || verbosity >= 1) {
@@ -115,7 +200,7 @@ void check_graph_extended(const my_graph& G) {
 		if (is_counterexample || verbosity >= 2) {
 			cout << " Divisor: [";
 			for (int i = 0; i < H.n; i++) {
-				cout << (i ? ", " : "") << __partial_divisor[i]; // find_gonality(H) stores the optimal divisor in __partial_divisor.
+				cout << (i ? ", " : "") << __partial_divisor[i]; // find_gonality stores the optimal divisor in __partial_divisor.
 			}
 			cout << ']';
 		}
@@ -148,12 +233,17 @@ void check_graph_fast(const my_graph& G) {
 		}
 	}
 	
-	// Compute gonality of subdivided graph
+	// Compute gonality of subdivided graph (unless tw(G) = gon(G) or a scramble on G has order gon(G), which
+	// rules out a smaller gonality).
 	my_graph H = subdivide(G, arg_k);
-	bool is_subdiv_counterexample = find_positive_rank_divisor(H, gon_G - 1);
+	bool is_subdiv_counterexample = false;
+	if (!settled_without_subdivision(G, gon_G)) {
+		is_subdiv_counterexample = find_positive_rank_divisor(H, gon_G - 1);
+	}
 	if (is_BN_counterexample || is_subdiv_counterexample) {
 		count_probs++;
 	}
+	record_result(G, m, gon_G, Brill_Noether_bound, is_BN_counterexample, is_subdiv_counterexample);
 	
 	// Print output if necessary
 	if (is_subdiv_counterexample || verbosity >= 1) {
@@ -184,6 +274,7 @@ void check_graph_fast(const my_graph& G) {
 }
 
 void solve(const my_graph& G) {
+	ALLOC_GRAPH(G.graph_name);
 	assert(arg_k >= 1 && arg_k <= MAX_PARTS_PER_EDGE);
 	assert(G.is_valid_undirected_graph());
 	if (arg_f) {
@@ -205,7 +296,9 @@ int main(int argc, char* argv[]) {
 	// Parse command-line arguments
 	bool badargs = false;
 	bool arg_g = false;
+	bool arg_p = false;
 	bool arg_h = false;
+	int arg_R = -1;
 	char tmp[30];
 	for (int i = 1; i < argc && !badargs; i++) {
 		unsigned l = strlen(argv[i]);
@@ -219,12 +312,31 @@ int main(int argc, char* argv[]) {
 					case 'g':
 						arg_g = true;
 						break;
+					case 'p':
+						arg_p = true;
+						break;
 					case 'f':
 						arg_f = true;
 						break;
 					case 'v':
 						verbosity++;
 						break;
+					case 'o':
+						// the file name is the next argument
+						if (j + 1 != l || i + 1 >= argc) {
+							badargs = true;
+						}
+						else {
+							results_path = argv[++i];
+						}
+						break;
+					case 'R':
+						// the number of threads is the next argument
+						if (j + 1 != l || i + 1 >= argc || sscanf(argv[++i], "%d", &arg_R) != 1 || arg_R < 1) {
+							cerr << "Error: option -R should be followed by the number of threads." << endl;
+							badargs = true;
+						}
+						break;
 					default:
 						badargs = true;
 						break;
@@ -260,23 +372,34 @@ int main(int argc, char* argv[]) {
 		usage();
 		exit(badargs ? 1 : 0);
 	}
+	if (arg_R != -1) {
+		parallel_rank_configure(arg_R, PARALLEL_RANK_MIN_N);
+	}
 	
 	// Read and process input
-	if (arg_g) {
+	compressed_istream input(cin);
+	if (arg_p) {
+		read_and_process_pipelined(input, arg_g, solve);
+	}
+	else if (arg_g) {
 		string s;
-		while (getline(cin, s)) {
+		while (getline(input, s)) {
 			my_graph G = parse_graph6(s);
 			G.graph_name = s;
 			solve(G);
 		}
 	}
 	else {
-		read_plain_input_and_process(cin, solve);
+		read_plain_input_and_process(input, solve);
 	}
+	results_db.close();
 	
 	// Print summary
 	cout << endl;
 	cout << "Summary: found " << count_probs << " counterexample" << (count_probs == 1 ? "." : "s.") << endl;
+	cout << "Settled by treewidth (no search on the subdivision): " << count_settled_by_treewidth << " of " << count_graphs << " graphs." << endl;
+	cout << "Settled by scrambles (no search on the subdivision): " << count_settled_by_scramble << " of " << count_graphs << " graphs." << endl;
+	alloc_stats_report();
 	return 0;
 }
 
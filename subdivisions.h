@@ -4,8 +4,10 @@
 #define __SUBDIVISIONS_H__
 
 #include "graphs.h"
+#include "alloc_stats.h"
 
 my_graph subdivide(const my_graph& G, int parts_per_edge) {
+	ALLOC_PHASE("subdivide");
 	assert(parts_per_edge >= 2 && parts_per_edge <= MAX_PARTS_PER_EDGE);
 	assert(G.is_valid_undirected_graph());
 	int m = G.count_edges();
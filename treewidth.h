@@ -0,0 +1,216 @@
+// Treewidth bounds.
+//
+// The treewidth of a graph is a lower bound for its (divisorial) gonality (van Dobben de Bruyn and
+// Gijswijt). Moreover, every subdivision H of G has G as a minor, so tw(H) >= tw(G). So if tw(G) = gon(G),
+// then gon(H) >= gon(G) for every subdivision H of G, and G cannot be a counterexample to the subdivision
+// conjecture (see subdivision_conjecture.cpp).
+//
+// Computing the treewidth is NP-hard, so this file provides:
+//
+//      * a lower bound (minor-min-width): repeatedly contract a vertex of minimum degree into its neighbour
+//        of minimum degree; the largest minimum degree encountered along the way is a lower bound, since
+//        every contracted graph is a minor of G. This takes O(n^2 + n m log n) time;
+//
+//      * an upper bound (minimum degree elimination ordering), in O(n^2 + n d^2 log n) time, where d is the
+//        maximum degree encountered;
+//
+//      * the exact treewidth for graphs with at most TREEWIDTH_EXACT_MAX_N vertices, by dynamic programming
+//        over vertex subsets (Bodlaender, Fomin, Koster, Kratsch and Thilikos): TW(S) is the minimum over
+//        the orderings of S of the largest number of vertices outside S that a vertex v in S can reach
+//        through the vertices before v; then tw(G) = TW(V). This takes O(2^n n^2) time and 2^n bytes.
+//
+// Parallel edges and loops do not affect the treewidth, and are ignored.
+//
+// This file defines the following functions:
+//
+//      * int treewidth_lower_bound(const my_graph& G)
+//        Lower bound for the treewidth of G (minor-min-width).
+//
+//      * int treewidth_upper_bound(const my_graph& G)
+//        Upper bound for the treewidth of G (minimum degree elimination ordering).
+//
+//      * int treewidth_exact(const my_graph& G)
+//        The treewidth of G (only for graphs with at most TREEWIDTH_EXACT_MAX_N vertices).
+//
+//      * bool treewidth_at_least(const my_graph& G, int k)
+//        Test whether tw(G) >= k, using the bounds above; returns false if this cannot be decided.
+//
+
+#ifndef __TREEWIDTH_H__
+#define __TREEWIDTH_H__
+
+#include "graphs.h"
+#include <cassert>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+
+const int TREEWIDTH_EXACT_MAX_N = 16; // maximum number of vertices for treewidth_exact()
+
+
+// Adjacency sets of the underlying simple graph (without loops and parallel edges).
+std::vector<std::set<int> > __treewidth_adjacency(const my_graph& G) {
+	std::vector<std::set<int> > adj(G.n);
+	for (int v = 0; v < G.n; v++) {
+		for (int w : G.neighbours[v]) {
+			if (w != v) {
+				adj[v].insert(w);
+			}
+		}
+	}
+	return adj;
+}
+
+// Index of a remaining vertex of minimum degree among the given candidates (the first one in case of ties).
+int __treewidth_min_degree(const std::vector<std::set<int> >& adj, const std::vector<bool>& removed, const std::set<int>& candidates) {
+	int best = -1;
+	for (int v : candidates) {
+		if (!removed[v] && (best == -1 || adj[v].size() < adj[best].size())) {
+			best = v;
+		}
+	}
+	return best;
+}
+
+
+// Lower bound for the treewidth of G (minor-min-width; see above). Returns 0 for graphs without edges.
+int treewidth_lower_bound(const my_graph& G) {
+	std::vector<std::set<int> > adj = __treewidth_adjacency(G);
+	std::vector<bool> removed(G.n, false);
+	std::set<int> all;
+	for (int v = 0; v < G.n; v++) {
+		all.insert(v);
+	}
+	int ret = 0;
+	for (int remaining = G.n; remaining >= 2; remaining--) {
+		const int u = __treewidth_min_degree(adj, removed, all);
+		if ((int) adj[u].size() > ret) {
+			ret = adj[u].size();
+		}
+		if (!adj[u].empty()) {
+			// Contract u into its neighbour v of minimum degree.
+			const int v = __treewidth_min_degree(adj, removed, adj[u]);
+			for (int w : adj[u]) {
+				adj[w].erase(u);
+				if (w != v) {
+					adj[w].insert(v);
+					adj[v].insert(w);
+				}
+			}
+		}
+		adj[u].clear();
+		removed[u] = true;
+		all.erase(u);
+	}
+	return ret;
+}
+
+
+// Upper bound for the treewidth of G (minimum degree elimination ordering; see above).
+int treewidth_upper_bound(const my_graph& G) {
+	std::vector<std::set<int> > adj = __treewidth_adjacency(G);
+	std::vector<bool> removed(G.n, false);
+	std::set<int> all;
+	for (int v = 0; v < G.n; v++) {
+		all.insert(v);
+	}
+	int ret = 0;
+	for (int remaining = G.n; remaining >= 1; remaining--) {
+		// Eliminate u: make its neighbourhood a clique, and remove it.
+		const int u = __treewidth_min_degree(adj, removed, all);
+		if ((int) adj[u].size() > ret) {
+			ret = adj[u].size();
+		}
+		for (int w : adj[u]) {
+			adj[w].erase(u);
+			for (int x : adj[u]) {
+				if (x != w) {
+					adj[w].insert(x);
+				}
+			}
+		}
+		adj[u].clear();
+		removed[u] = true;
+		all.erase(u);
+	}
+	return ret;
+}
+
+
+// The treewidth of G, for graphs with at most TREEWIDTH_EXACT_MAX_N vertices (see above). Returns 0 for
+// graphs without edges.
+int treewidth_exact(const my_graph& G) {
+	assert(G.n >= 1 && G.n <= TREEWIDTH_EXACT_MAX_N);
+	const int n = G.n;
+	uint32_t adj[TREEWIDTH_EXACT_MAX_N];
+	for (int v = 0; v < n; v++) {
+		adj[v] = 0;
+		for (int w : G.neighbours[v]) {
+			if (w != v) {
+				adj[v] |= uint32_t(1) << w;
+			}
+		}
+	}
+	const uint32_t all = (uint32_t(1) << n) - 1;
+	std::vector<signed char> TW(all + 1);
+	TW[0] = 0;
+	for (uint32_t S = 1; S <= all; S++) {
+		int best = n;
+		for (int v = 0; v < n; v++) {
+			if (!((S >> v) & 1)) {
+				continue;
+			}
+			const uint32_t rest = S & ~(uint32_t(1) << v);
+			if (TW[rest] >= best) {
+				continue;
+			}
+			// Count the vertices outside S that v can reach through rest.
+			uint32_t reach = adj[v], seen = adj[v] & rest, frontier = seen;
+			while (frontier != 0) {
+				int x = 0;
+				while (!((frontier >> x) & 1)) {
+					x++;
+				}
+				frontier &= frontier - 1;
+				reach |= adj[x];
+				const uint32_t next = adj[x] & rest & ~seen;
+				seen |= next;
+				frontier |= next;
+			}
+			reach &= ~S;
+			int q = 0;
+			for (; reach != 0; reach &= reach - 1) {
+				q++;
+			}
+			const int value = (TW[rest] > q ? TW[rest] : q);
+			if (value < best) {
+				best = value;
+			}
+		}
+		TW[S] = best;
+	}
+	return TW[all];
+}
+
+
+// Test whether tw(G) >= k. Uses the lower bound first, and the exact treewidth for small graphs (unless the
+// upper bound is smaller than k). Returns false if tw(G) < k, or if this cannot be decided.
+bool treewidth_at_least(const my_graph& G, const int k) {
+	if (k <= 0) {
+		return true;
+	}
+	if (G.n == 0) {
+		return false;
+	}
+	if (treewidth_lower_bound(G) >= k) {
+		return true;
+	}
+	if (G.n > TREEWIDTH_EXACT_MAX_N || treewidth_upper_bound(G) < k) {
+		return false;
+	}
+	return treewidth_exact(G) >= k;
+}
+
+
+#endif
@@ -0,0 +1,318 @@
+// This program reads gonality certificates (as written by find_gonality -c; see certificates.h) from
+// standard input, and checks them.
+//
+// Usage:
+//       ./verify_gonality [-ev] < certificates.txt
+//
+//       Options:
+//       -e  : re-check exhaustive lower bounds, by repeating the brute force search of degree deg(D) - 1
+//             (this is as slow as computing the gonality in the first place)
+//
+//       Output options:
+//       -v  : verbose (print a line for every certificate, not just for the ones that fail)
+//
+// For every certificate, the following is checked:
+//     * the graph is well-formed (vertices in range, no loops);
+//     * the divisor D is effective;
+//     * upper bound: for every vertex u, the divisor D - L s_u is effective and has at least one chip on u,
+//       where s_u is the script for u given in the certificate. This proves that D has positive rank, so
+//       the gonality is at most deg(D);
+//     * lower bound: if the method is "trivial", that deg(D) = 1; if the method is "exhaustive", that the
+//       recorded number of tried divisors equals the number of all effective divisors of degree deg(D) - 1
+//       with at least one chip on vertex 0 (i.e. that the brute force search was complete). This count
+//       does not prove anything by itself: the outcome of the individual rank computations in the search
+//       can only be checked by repeating the search, which is done with -e. Without -e, exhaustive lower
+//       bounds are reported as not checked, and do not count as verified. If the method is "scramble",
+//       that the eggs are disjoint and connected, and that the scramble has order at least deg(D) (see
+//       scramble.h); this proves the lower bound completely.
+//
+// Checking the upper bound takes O(n (n + m)) time per certificate, so this program is much faster than
+// recomputing the gonality (unless -e is used). The program exits with status 1 if any certificate fails.
+
+
+#define USAGE_STRING \
+"verify_gonality [-ev] < certificates.txt"
+
+#define HELPTEXT \
+" Check the gonality certificates in the file \"certificates.txt\" (see find_gonality -c).\n\
+\n\
+\n\
+    Options:\n\
+       -e    : re-check exhaustive lower bounds by repeating the brute force search (slow)\n\
+\n\
+    Output options:\n\
+       -v    : verbose (print a line for every certificate, not just for the ones that fail)\n\
+\n\
+  See program text for much more information.\n"
+
+
+// Graph limits (should be defined BEFORE loading graphs.h or certificates.h).
+# ifndef __GRAPH_LIMITS__
+# define __GRAPH_LIMITS__
+const int MAX_N = 1500;
+const int MAX_M = 100000;
+const int MAX_PARTS_PER_EDGE = 10;
+# endif
+
+#include "graphs.h"
+#include "certificates.h"
+#include "compressed_input.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <cassert>
+
+using namespace std;
+
+int verbosity = 0;
+bool arg_e = false;
+
+long long count_certificates = 0;
+long long count_failed = 0;
+long long count_trivial = 0;
+long long count_exhaustive = 0;
+long long count_exhaustive_unchecked = 0;
+long long count_scramble = 0;
+
+// The certificate currently being checked.
+int cert_n, cert_m;
+int edge_a[MAX_M], edge_b[MAX_M];
+int cert_divisor[MAX_N];
+int cert_degree[MAX_N];
+long long cert_value[MAX_N];
+int cert_script[MAX_N];
+vector<vector<int> > cert_eggs;
+
+
+// Minimal tokenizer for the current line.
+const char* cur;
+
+void skip_spaces() {
+	while (*cur == ' ' || *cur == '\t' || *cur == '\r') {
+		cur++;
+	}
+}
+
+bool read_keyword(const char* kw) {
+	skip_spaces();
+	size_t l = strlen(kw);
+	if (strncmp(cur, kw, l) != 0 || (cur[l] != ' ' && cur[l] != '\t' && cur[l] != '\0' && cur[l] != '\r')) {
+		return false;
+	}
+	cur += l;
+	return true;
+}
+
+bool read_int(long long& x) {
+	skip_spaces();
+	bool neg = (*cur == '-');
+	if (neg) {
+		cur++;
+	}
+	if (*cur < '0' || *cur > '9') {
+		return false;
+	}
+	x = 0;
+	while (*cur >= '0' && *cur <= '9') {
+		if (x > (LLONG_MAX - 9) / 10) {
+			return false;
+		}
+		x = 10 * x + (*cur - '0');
+		cur++;
+	}
+	if (neg) {
+		x = -x;
+	}
+	return true;
+}
+
+bool read_int_in_range(int& x, long long lo, long long hi) {
+	long long y;
+	if (!read_int(y) || y < lo || y > hi) {
+		return false;
+	}
+	x = y;
+	return true;
+}
+
+
+// Check a single certificate. Returns NULL on success, or a description of the problem.
+const char* check_certificate(const string& line, string& lower_bound_method) {
+	cur = line.c_str();
+	if (!read_keyword("C")) return "expected 'C'";
+	if (!read_int_in_range(cert_n, 1, MAX_N)) return "invalid number of vertices";
+	if (!read_int_in_range(cert_m, 0, MAX_M)) return "invalid number of edges";
+	for (int i = 0; i < cert_n; i++) {
+		cert_degree[i] = 0;
+	}
+	for (int e = 0; e < cert_m; e++) {
+		if (!read_int_in_range(edge_a[e], 0, cert_n - 1) || !read_int_in_range(edge_b[e], 0, cert_n - 1)) return "invalid edge";
+		if (edge_a[e] == edge_b[e]) return "graph has a loop";
+		cert_degree[edge_a[e]]++;
+		cert_degree[edge_b[e]]++;
+	}
+	if (!read_keyword("D")) return "expected 'D'";
+	long long deg = 0;
+	for (int i = 0; i < cert_n; i++) {
+		if (!read_int_in_range(cert_divisor[i], 0, INT_MAX)) return "divisor is not effective";
+		deg += cert_divisor[i];
+	}
+	if (deg < 1) return "divisor has degree 0";
+
+	// Upper bound: D - L s_u must be effective with at least one chip on u.
+	if (!read_keyword("S")) return "expected 'S'";
+	for (int u = 0; u < cert_n; u++) {
+		for (int i = 0; i < cert_n; i++) {
+			if (!read_int_in_range(cert_script[i], INT_MIN, INT_MAX)) return "invalid script";
+			cert_value[i] = cert_divisor[i] - (long long) cert_degree[i] * cert_script[i];
+		}
+		for (int e = 0; e < cert_m; e++) {
+			cert_value[edge_a[e]] += cert_script[edge_b[e]];
+			cert_value[edge_b[e]] += cert_script[edge_a[e]];
+		}
+		for (int i = 0; i < cert_n; i++) {
+			if (cert_value[i] < 0) return "script yields a non-effective divisor";
+		}
+		if (cert_value[u] < 1) return "script does not move a chip to its target";
+	}
+
+	// Lower bound.
+	if (!read_keyword("L")) return "expected 'L'";
+	if (read_keyword("trivial")) {
+		lower_bound_method = "trivial";
+		if (deg != 1) return "trivial lower bound only applies to gonality 1";
+		count_trivial++;
+	}
+	else if (read_keyword("exhaustive")) {
+		lower_bound_method = "exhaustive";
+		long long leaves;
+		if (!read_int(leaves) || leaves < 0) return "invalid search tree summary";
+		if (deg < 2) return "exhaustive lower bound requires gonality at least 2";
+		unsigned long long expected = count_search_leaves(cert_n, deg - 1);
+		if (expected == ULLONG_MAX || (unsigned long long) leaves != expected) return "search tree summary does not match a complete search";
+		if (!arg_e) {
+			lower_bound_method = "exhaustive, not checked";
+			count_exhaustive_unchecked++;
+		}
+		else {
+			my_graph G;
+			G.setN(cert_n);
+			for (int e = 0; e < cert_m; e++) {
+				G.add_edge(edge_a[e], edge_b[e]);
+			}
+			if (find_positive_rank_divisor(G, deg - 1)) return "found a positive rank divisor of smaller degree";
+			count_exhaustive++;
+		}
+	}
+	else if (read_keyword("scramble")) {
+		lower_bound_method = "scramble";
+		int k;
+		if (!read_int_in_range(k, 0, cert_n)) return "invalid number of eggs";
+		cert_eggs.assign(k, vector<int>());
+		for (int i = 0; i < k; i++) {
+			int size;
+			if (!read_int_in_range(size, 1, cert_n)) return "invalid egg size";
+			cert_eggs[i].resize(size);
+			for (int j = 0; j < size; j++) {
+				if (!read_int_in_range(cert_eggs[i][j], 0, cert_n - 1)) return "invalid vertex in egg";
+			}
+		}
+		my_graph G;
+		G.setN(cert_n);
+		for (int e = 0; e < cert_m; e++) {
+			G.add_edge(edge_a[e], edge_b[e]);
+		}
+		const int order = scramble_order(G, cert_eggs);
+		if (order == -1) return "eggs are not disjoint and connected";
+		if (order < deg) return "scramble order is smaller than the degree of the divisor";
+		count_scramble++;
+	}
+	else {
+		return "unknown lower bound method";
+	}
+	skip_spaces();
+	if (*cur != '\0') return "trailing garbage";
+	return NULL;
+}
+
+void usage() {
+	cerr << endl;
+	cerr << "Usage: " << USAGE_STRING << endl;
+	cerr << endl;
+	cerr << HELPTEXT << endl;
+}
+
+int main(int argc, char* argv[]) {
+	// Parse command-line arguments
+	bool badargs = false;
+	bool arg_h = false;
+	for (int i = 1; i < argc && !badargs; i++) {
+		unsigned l = strlen(argv[i]);
+		assert(l >= 1);
+		if (argv[i][0] == '-') {
+			for (unsigned j = 1; j < l; j++) {
+				switch (argv[i][j]) {
+					case 'e':
+						arg_e = true;
+						break;
+					case 'h':
+						arg_h = true;
+						break;
+					case 'v':
+						verbosity++;
+						break;
+					default:
+						badargs = true;
+						break;
+				}
+			}
+		}
+		else {
+			badargs = true;
+		}
+	}
+	if (arg_h || badargs) {
+		cerr << (badargs ? "Invalid argument(s)." : "Requested help.") << endl;
+		usage();
+		exit(badargs ? 1 : 0);
+	}
+
+	// Read and check certificates
+	ios::sync_with_stdio(false);
+	string line, name, method;
+	long long line_number = 0;
+	compressed_istream input(cin);
+	while (getline(input, line)) {
+		line_number++;
+		if (line.empty()) {
+			continue;
+		}
+		if (line[0] == '#') {
+			name = line.substr(line.size() >= 2 && line[1] == ' ' ? 2 : 1);
+			continue;
+		}
+		count_certificates++;
+		const char* problem = check_certificate(line, method);
+		if (problem != NULL) {
+			count_failed++;
+			cout << "Certificate " << count_certificates << " (line " << line_number << (name.empty() ? "" : ", ") << name << "): FAILED (" << problem << ")." << '\n';
+		}
+		else if (verbosity >= 1) {
+			cout << "Certificate " << count_certificates << " (line " << line_number << (name.empty() ? "" : ", ") << name << "): OK (lower bound: " << method << ")." << '\n';
+		}
+		name.clear();
+	}
+
+	// Print summary
+	cout << endl;
+	cout << "Summary: checked " << count_certificates << " certificate" << (count_certificates == 1 ? "" : "s") << "; " << count_failed << " failed." << endl;
+	cout << "         Lower bounds: " << count_trivial << " trivial, " << count_exhaustive << " by repeating the exhaustive search, " << count_scramble << " by scrambles." << endl;
+	if (count_exhaustive_unchecked > 0) {
+		cout << "         Not checked: " << count_exhaustive_unchecked << " exhaustive lower bound" << (count_exhaustive_unchecked == 1 ? "" : "s") << " (use -e to repeat the search)." << endl;
+	}
+	return (count_failed == 0 ? 0 : 1);
+}